@@ -30,6 +30,7 @@ extern "C" {
 #include "caption.h"
 #include "cea708.h"
 #include "scc.h"
+#include "scheduler.h"
 #include <float.h>
 ////////////////////////////////////////////////////////////////////////////////
 #define MAX_NALU_SIZE (4 * 1024 * 1024)
@@ -191,6 +192,12 @@ void sei_dump_messages(sei_message_t* head);
     \param
 */
 libcaption_stauts_t sei_from_scc(sei_t* sei, const scc_t* scc);
+/*! \brief Writes the field 1 608 data in sei to an SCC writer, at the sei's pts
+    \param
+
+    Words that fail the parity check are left out.
+*/
+libcaption_stauts_t sei_to_scc(sei_t* sei, scc_writer_t* writer);
 /*! \brief
     \param
 */
@@ -199,10 +206,76 @@ libcaption_stauts_t sei_from_caption_frame(sei_t* sei, caption_frame_t* frame);
     \param
 */
 libcaption_stauts_t sei_from_caption_clear(sei_t* sei);
+/*! \brief Appends the cc_data for the next video frame from sched
+    \param
+*/
+libcaption_stauts_t sei_from_caption_scheduler(sei_t* sei, caption_scheduler_t* sched);
+/*! \brief Merges the 608 cc_data of from into the padding slots of the GA94 message in sei
+    \param
+
+    Only that message is re-rendered, and its size does not change. Returns LIBCAPTION_ERROR,
+    leaving sei untouched, if sei has no GA94 cc_data message or it has too few free slots.
+*/
+libcaption_stauts_t sei_merge_cea708(sei_t* sei, sei_t* from);
+/*! \brief Appends every GA94 cc_data message of sei to batch
+    \param
+
+    Returns the number of messages appended. Messages that do not fit are skipped, so
+    flush the batch once it is full.
+*/
+size_t sei_to_cea708_batch(sei_t* sei, cea708_batch_t* batch);
+/*! \brief Renders cea708 into a new message appended to sei, and reinitializes cea708
+    \param
+*/
+void sei_append_708(sei_t* sei, cea708_t* cea708);
 /*! \brief
     \param
 */
 libcaption_stauts_t sei_to_caption_frame(sei_t* sei, caption_frame_t* frame);
+/*! \brief Like sei_to_caption_frame(), but DTVCC packets in the same messages are fed to dtvcc
+    \param frame may be NULL to skip 608
+    \param dtvcc may be NULL to skip 708
+*/
+libcaption_stauts_t sei_demux(sei_t* sei, caption_frame_t* frame, dtvcc_t* dtvcc);
+////////////////////////////////////////////////////////////////////////////////
+// LRU cache of rendered caption SEI NALUs (nal_unit_type, escaped payload and stop bit).
+// Entries are keyed by a hash of the caption text or of the scc cc_data
+typedef struct _sei_cache_entry_t sei_cache_entry_t;
+typedef struct {
+    size_t size;
+    size_t capacity;
+    unsigned int hits;
+    unsigned int misses;
+    sei_cache_entry_t* head; // most recently used
+    sei_cache_entry_t* tail; // next to be evicted
+    sei_cache_entry_t** bucket;
+    size_t bucket_mask;
+} sei_cache_t;
+
+/*! \brief Initializes a cache holding up to capacity rendered NALUs
+    \param
+*/
+void sei_cache_init(sei_cache_t* cache, size_t capacity);
+/*! \brief
+    \param
+*/
+void sei_cache_free(sei_cache_t* cache);
+/*! \brief Returns the SEI NALU for a pop-on caption of text, or for a clear if text is NULL
+    \param size is set to the size of the NALU
+
+    The returned data is owned by the cache, and is valid until the next call to sei_cache_render_*()
+*/
+const uint8_t* sei_cache_render_text(sei_cache_t* cache, const utf8_char_t* text, size_t* size);
+/*! \brief Returns the SEI NALU for the cc_data in scc
+    \param size is set to the size of the NALU
+*/
+const uint8_t* sei_cache_render_scc(sei_cache_t* cache, const scc_t* scc, size_t* size);
+/*! \brief
+    \param
+*/
+static inline unsigned int sei_cache_hits(sei_cache_t* cache) { return cache->hits; }
+static inline unsigned int sei_cache_misses(sei_cache_t* cache) { return cache->misses; }
+////////////////////////////////////////////////////////////////////////////////
 /*! \brief
     \param
 */
@@ -123,6 +123,24 @@ libcaption_stauts_t caption_frame_decode(caption_frame_t* frame, uint16_t cc_dat
     \param
 */
 int caption_frame_from_text(caption_frame_t* frame, const utf8_char_t* data);
+/*! \brief Encodes displayed memory as a pop-on caption: ENM, RCL, preambles and text, then EOC
+    \param cc_data receives at most size words. CAPTION_FRAME_CC_DATA_SIZE is always enough
+    Returns the number of words written
+*/
+#define CAPTION_FRAME_CC_DATA_SIZE (3 + SCREEN_ROWS * (2 + 2 * SCREEN_COLS))
+size_t caption_frame_to_608(caption_frame_t* frame, uint16_t* cc_data, size_t size);
+/*! \brief Encodes the shortest command sequence we can find that turns the displayed memory of prev into that of next
+    \param prev What decoders currently display. On return it is updated to what they display after cc_data,
+    which is only part of the way to next if size was too small. Some charcters take two words, so
+    calling again with room for less than four may not get any further
+    \param cc_data receives at most size words. CAPTION_FRAME_DELTA_CC_DATA_SIZE is always enough
+    Changes are painted on, or rolled up if next is in roll-up mode. When rolling up, preambles only
+    address the base row of next; the rows above it are written there and moved up by carriage returns.
+    Styles are not encoded.
+    Returns the number of words written
+*/
+#define CAPTION_FRAME_DELTA_CC_DATA_SIZE (16 + 8 * SCREEN_ROWS * SCREEN_COLS)
+size_t caption_frame_delta_608(caption_frame_t* prev, caption_frame_t* next, uint16_t* cc_data, size_t size);
 /*! \brief
     \param
 */
@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 #include "caption.h"
+#include "dvtcc.h"
 #define CEA608_MAX_SIZE (255)
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -101,10 +102,26 @@ int cea708_parse(uint8_t* data, size_t size, cea708_t* cea708);
     \param
 */
 libcaption_stauts_t cea708_to_caption_frame(caption_frame_t* frame, cea708_t* cea708, double pts);
+/*! \brief Walks the cc_data once, decoding field 1 into frame and feeding DTVCC packets to dtvcc
+    \param frame may be NULL to skip 608
+    \param dtvcc may be NULL to skip 708
+
+    Returns the status of frame, as cea708_to_caption_frame() does. Malformed DTVCC packets
+    are dropped by dtvcc.
+*/
+libcaption_stauts_t cea708_demux(cea708_t* cea708, caption_frame_t* frame, dtvcc_t* dtvcc, double pts);
 /*! \brief
     \param
 */
 int cea708_add_cc_data(cea708_t* cea708, int valid, cea708_cc_type_t type, uint16_t cc_data);
+/*! \brief Moves the 608 pairs of from into the padding and invalid cc_data slots of cea708
+    \param
+
+    Pairs keep their order, and cc_count is not changed. Only slots before the first DTVCC
+    pair are used, as 608 data must come first. Returns LIBCAPTION_ERROR, leaving cea708
+    untouched, if there are not enough free slots there.
+*/
+libcaption_stauts_t cea708_merge_cc_data(cea708_t* cea708, cea708_t* from);
 /*! \brief
     \param
 */
@@ -113,6 +130,51 @@ int cea708_render(cea708_t* cea708, uint8_t* data, size_t size);
     \param
 */
 void cea708_dump(cea708_t* cea708);
+////////////////////////////////////////////////////////////////////////////////
+// cc_data of many GA94 messages, as separate valid, type and data arrays. Message i
+// owns CEA708_BATCH_STRIDE slots starting at i * CEA708_BATCH_STRIDE, and slots past its
+// cc_count are zero, so the arrays can be scanned flat without looking at cc_count
+#define CEA708_BATCH_STRIDE 32
+typedef struct {
+    size_t size; // messages in the batch
+    size_t capacity;
+    uint8_t* cc_count;
+    uint8_t* em_data;
+    uint8_t* flags; // process_em_data, process_cc_data and additional_data, as on the wire
+    uint8_t* cc_valid;
+    uint8_t* cc_type; // castable to cea708_cc_type_t
+    uint16_t* cc_data;
+} cea708_batch_t;
+
+/*! \brief Allocates a batch of capacity messages
+    \param
+*/
+void cea708_batch_init(cea708_batch_t* batch, size_t capacity);
+/*! \brief
+    \param
+*/
+void cea708_batch_free(cea708_batch_t* batch);
+/*! \brief Empties the batch, keeping its memory
+    \param
+*/
+void cea708_batch_clear(cea708_batch_t* batch);
+/*! \brief Appends a user_data_registered_itu_t_t35 payload to the batch
+    \param
+
+    Returns LIBCAPTION_READY if the batch is now full, and LIBCAPTION_ERROR, appending
+    nothing, if the batch was already full or data is not GA94 cc_data.
+*/
+libcaption_stauts_t cea708_batch_parse(cea708_batch_t* batch, const uint8_t* data, size_t size);
+/*! \brief Renders message index of the batch as a user_data_registered_itu_t_t35 payload
+    \param size must be at least CEA608_MAX_SIZE, or cea708_batch_render_size()
+
+    Returns the number of bytes written.
+*/
+size_t cea708_batch_render(cea708_batch_t* batch, size_t index, uint8_t* data, size_t size);
+static inline size_t cea708_batch_render_size(cea708_batch_t* batch, size_t index) { return 11 + 3 * batch->cc_count[index]; }
+static inline uint8_t* cea708_batch_cc_valid(cea708_batch_t* batch, size_t index) { return &batch->cc_valid[index * CEA708_BATCH_STRIDE]; }
+static inline uint8_t* cea708_batch_cc_type(cea708_batch_t* batch, size_t index) { return &batch->cc_type[index * CEA708_BATCH_STRIDE]; }
+static inline uint16_t* cea708_batch_cc_data(cea708_batch_t* batch, size_t index) { return &batch->cc_data[index * CEA708_BATCH_STRIDE]; }
 #ifdef __cplusplus
 }
 #endif
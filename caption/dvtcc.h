@@ -1,19 +1,157 @@
-#ifndef LIBCAPTION_CEA708_H
-#define LIBCAPTION_CEA708_H
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#ifndef LIBCAPTION_DVTCC_H
+#define LIBCAPTION_DVTCC_H
 #ifdef __cplusplus
 extern "C" {
 #endif
+
+#include "caption.h"
+////////////////////////////////////////////////////////////////////////////////
+// CEA-708 DTVCC transport. cc_type 3 starts a packet, cc_type 2 continues it. Each
+// complete packet is split into service blocks, and every block is handed to the
+// callback as it is found
+#define DTVCC_MAX_PACKET_SIZE 128
+#define DTVCC_MAX_SERVICE_NUMBER 63
+
+typedef void (*dtvcc_service_block_callback_t)(void* opaque, int service_number, const uint8_t* data, size_t size);
+
+typedef struct {
+    int sequence_number; // of the last complete packet, -1 before the first
+    size_t packet_size; // expected bytes, including the packet header
+    size_t size; // bytes received, 0 while waiting for a packet start
+    uint8_t packet[DTVCC_MAX_PACKET_SIZE];
+    dtvcc_service_block_callback_t callback;
+    void* opaque;
+} dtvcc_t;
+
+/*! \brief
+    \param callback is called once for every service block. May be NULL
+*/
+void dtvcc_init(dtvcc_t* dtvcc, dtvcc_service_block_callback_t callback, void* opaque);
+/*! \brief Feeds one valid cc_data pair of cc_type 2 or 3
+    \param start is non zero for cc_type_dtvcc_packet_start
+
+    Returns LIBCAPTION_READY once a packet is complete and its service blocks have been
+    delivered, and LIBCAPTION_ERROR if a packet was cut short or is malformed. Data
+    received before the first packet start is ignored.
+*/
+libcaption_stauts_t dtvcc_decode(dtvcc_t* dtvcc, int start, uint16_t cc_data);
 ////////////////////////////////////////////////////////////////////////////////
-struct dtvcc_packet_t {
-    unsigned int sequence_number;
-    unsigned int packet_size;
-    unsigned int serice_number;
-};
+// CEA-708 service decoder. Every service keeps its eight windows in a fixed arena, so
+// decoding never allocates, and marks the windows it changes in dirty
+#define DTVCC_WINDOW_COUNT 8
+#define DTVCC_WINDOW_ROWS 15
+#define DTVCC_WINDOW_COLS 42
+#define DTVCC_COMMAND_MAX_SIZE 128
+
+typedef enum {
+    dtvcc_direction_left_to_right = 0,
+    dtvcc_direction_right_to_left = 1,
+    dtvcc_direction_top_to_bottom = 2,
+    dtvcc_direction_bottom_to_top = 3,
+} dtvcc_direction_t;
+
+// A character and the pen it was written with. Colors are 2 bits each of r, g and b
+typedef struct {
+    unsigned int code : 16; // unicode code point, 0 for an empty or transparent cell
+    unsigned int fg_color : 6;
+    unsigned int fg_opacity : 2;
+    unsigned int bg_color : 6;
+    unsigned int bg_opacity : 2;
+    unsigned int edge_color : 6;
+    unsigned int edge_type : 3;
+    unsigned int font_style : 3;
+    unsigned int pen_size : 2;
+    unsigned int offset : 2;
+    unsigned int text_tag : 4;
+    unsigned int italics : 1;
+    unsigned int underline : 1;
+} dtvcc_cell_t;
+
+typedef struct {
+    uint8_t defined;
+    uint8_t visible;
+    uint8_t row_lock;
+    uint8_t column_lock;
+    uint8_t priority;
+    uint8_t relative_positioning;
+    uint8_t anchor_vertical;
+    uint8_t anchor_horizontal;
+    uint8_t anchor_point;
+    uint8_t row_count; // 1 to DTVCC_WINDOW_ROWS
+    uint8_t column_count; // 1 to DTVCC_WINDOW_COLS
+    // window attributes
+    uint8_t justify;
+    uint8_t print_direction; // dtvcc_direction_t
+    uint8_t scroll_direction; // dtvcc_direction_t
+    uint8_t word_wrap;
+    uint8_t display_effect;
+    uint8_t effect_direction;
+    uint8_t effect_speed;
+    uint8_t fill_color;
+    uint8_t fill_opacity;
+    uint8_t border_type;
+    uint8_t border_color;
+    // pen location and attributes, pen.code is unused. The pen may sit one step past
+    // the edge after the last character of a line
+    int row;
+    int col;
+    dtvcc_cell_t pen;
+} dtvcc_window_t;
+
+typedef struct {
+    int current; // current window, -1 if none
+    uint8_t dirty; // bitmap of windows changed since the caller last cleared it
+    size_t pending; // bytes of a command split across service blocks
+    uint8_t command[DTVCC_COMMAND_MAX_SIZE];
+    dtvcc_window_t window[DTVCC_WINDOW_COUNT];
+    dtvcc_cell_t cell[DTVCC_WINDOW_COUNT][DTVCC_WINDOW_ROWS][DTVCC_WINDOW_COLS];
+} dtvcc_service_t;
 
-#defing DVTCC_SERVICE_NUMBER_UNKNOWN
+/*! \brief
+    \param
+*/
+void dtvcc_service_init(dtvcc_service_t* service);
+/*! \brief Decodes one service block, as delivered to a dtvcc_service_block_callback_t
+    \param
 
-// static inline size_t dvtvcc_packet_size_bytes(const struct dtvcc_packet_t *dvtcc) { return dvtcc->packet_size*2-1;}
+    Returns LIBCAPTION_READY if a visible window changed, or a window was shown, hidden or
+    deleted. The changed windows are or'ed into service->dirty. The delay commands are
+    parsed but not honored, commands are applied as they arrive.
+*/
+libcaption_stauts_t dtvcc_service_decode(dtvcc_service_t* service, const uint8_t* data, size_t size);
+/*! \brief Writes the text of a window as utf8, one line per row with trailing blanks trimmed
+    \param
 
+    Returns the number of bytes written, not counting the terminating null.
+*/
+size_t dtvcc_window_to_text(dtvcc_service_t* service, int window, utf8_char_t* data, size_t size);
+/*! \brief Prints every defined window to stderr
+    \param
+*/
+void dtvcc_service_dump(dtvcc_service_t* service);
 ////////////////////////////////////////////////////////////////////////////////
 #ifdef __cplusplus
 }
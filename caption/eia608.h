@@ -66,6 +66,16 @@ static inline int eia608_parity_varify(uint16_t cc_data) { return eia608_parity_
     \param
 */
 static inline int eia608_parity_strip(uint16_t cc_data) { return cc_data & 0x7F7F; }
+/*! \brief Sets odd parity on count words in place
+    \param cc_data array of words, any existing parity bits are replaced
+
+    Uses SSE2 when the target supports it.
+*/
+void eia608_parity_words(uint16_t* cc_data, size_t count);
+/*! \brief Checks the parity of count words
+    \return Number of leading words with valid parity, count if all of them are valid
+*/
+size_t eia608_parity_varify_words(const uint16_t* cc_data, size_t count);
 /*! \brief
     \param
 */
@@ -194,6 +204,18 @@ uint16_t eia608_from_utf8_2(const utf8_char_t* c1, const utf8_char_t* c2);
     \param
 */
 uint16_t eia608_from_basicna(uint16_t bna1, uint16_t bna2);
+/*! \brief Decodes a text pair into eia608_char_map indices
+    \param c1 and c2 receive an index into eia608_char_map, or -1 if unused
+    \return number of characters decoded (0, 1 or 2)
+*/
+int eia608_to_index(uint16_t cc_data, int* chan, int* c1, int* c2);
+/*! \brief Decodes a text pair without copying
+    \param char1 and char2 receive pointers into eia608_char_map, or to an empty string if unused
+    \return number of characters decoded (0, 1 or 2)
+
+    The returned strings are static and must not be freed or modified.
+*/
+int eia608_to_char(uint16_t c, int* chan, const utf8_char_t** char1, const utf8_char_t** char2);
 /*! \brief
     \param
 */
@@ -0,0 +1,74 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#ifndef LIBCAPTION_ENCODER_H
+#define LIBCAPTION_ENCODER_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "caption.h"
+#include "scheduler.h"
+
+typedef enum {
+    caption_encoder_paint_on = 0,
+    caption_encoder_roll_up_2 = 2,
+    caption_encoder_roll_up_3 = 3,
+    caption_encoder_roll_up_4 = 4,
+} caption_encoder_mode_t;
+
+// paint-on uses the bottom rows of the screen, and starts over at the top once they are full
+#define CAPTION_ENCODER_PAINT_ON_ROWS 4
+
+typedef struct {
+    caption_encoder_mode_t mode;
+    int newline; //< a line break is waiting for the next charcter
+    caption_frame_t shown; //< what decoders display after everything encoded so far
+    caption_frame_t frame; //< what we want displayed
+} caption_encoder_t;
+
+/*! \brief
+    \param
+*/
+void caption_encoder_init(caption_encoder_t* enc, caption_encoder_mode_t mode);
+/*! \brief Appends text, which may be a single keystroke, a word or several lines
+    \param cc_data receives the 608 commands to display it, at most size words
+    '\n' starts a new line, and '\b' erases the previous charcter. Words wrap at SCREEN_COLS.
+    Returns the number of words written
+*/
+size_t caption_encoder_write(caption_encoder_t* enc, const utf8_char_t* text, uint16_t* cc_data, size_t size);
+/*! \brief Appends text like caption_encoder_write, and queues the commands on sched
+    \param text may be "" to send again what an earlier push could not queue
+    Returns LIBCAPTION_ERROR if sched has no room. The text is kept, and what decoders are
+    known to display is left as it was, so the next push sends the commands again
+*/
+libcaption_stauts_t caption_encoder_push(caption_encoder_t* enc, caption_scheduler_t* sched, const utf8_char_t* text);
+/*! \brief Erases the screen
+    \param
+*/
+size_t caption_encoder_clear(caption_encoder_t* enc, uint16_t* cc_data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -40,6 +40,62 @@ scc_t* scc_new(int cc_count);
 scc_t* scc_free(scc_t* scc);
 
 size_t scc_to_608(scc_t** scc, const utf8_char_t* data);
+////////////////////////////////////////////////////////////////////////////////
+// Reads a whole SCC document one caption line at a time, reusing one scc_t
+typedef struct {
+    const utf8_char_t* data;
+    const utf8_char_t* end;
+    int drop_frame; // timecode of the last line used ';'
+    size_t parity_errors; // words read so far that fail the odd parity check
+    scc_t* scc;
+} scc_reader_t;
+
+/*! \brief Converts an SCC timecode into seconds
+    \param drop_frame set for ';' timecodes, which skip frame numbers 0 and 1 of each minute except every tenth
+
+    SCC video is always 29.97 fps, non drop frame timecodes count 30 frames a second and drift from real time
+*/
+double scc_timecode_to_timestamp(int hh, int mm, int ss, int ff, int drop_frame);
+/*! \brief
+    \param data the whole document, reading also stops at a null terminator
+
+    Returns 0 if data does not start with a supported 'Scenarist_SCC V1.0' header
+*/
+int scc_reader_init(scc_reader_t* reader, const utf8_char_t* data, size_t size);
+/*! \brief
+    \param
+*/
+void scc_reader_free(scc_reader_t* reader);
+/*! \brief Decodes the next caption line
+    \param
+
+    Returns the line, which stays valid until the next call, or 0 at the end of the document.
+    Lines that are not a timecode followed by hex words are skipped.
+*/
+scc_t* scc_reader_next(scc_reader_t* reader);
+////////////////////////////////////////////////////////////////////////////////
+// Writes SCC from a stream of field 1 cc_data, one word per 29.97 fps frame
+typedef struct {
+    utf8_writer_t* writer;
+    int drop_frame;
+    int64_t frame; // frame the next word on the current line lands on, -1 when no line is open
+} scc_writer_t;
+
+/*! \brief Writes the 'Scenarist_SCC V1.0' header
+    \param drop_frame write ';' drop frame timecodes instead of ':' non drop frame ones
+*/
+void scc_writer_init(scc_writer_t* writer, utf8_writer_t* output, int drop_frame);
+/*! \brief Adds one word at timestamp (in seconds)
+    \param
+
+    Padding (0x8080) is not written. Words continue the current line while they keep up with
+    it, a word that arrives after a gap starts a new line with its own timecode.
+*/
+void scc_writer_write(scc_writer_t* writer, double timestamp, uint16_t cc_data);
+/*! \brief Ends the current line and flushes the output
+    \param
+*/
+int scc_writer_flush(scc_writer_t* writer);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,85 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#ifndef LIBCAPTION_SCHEDULER_H
+#define LIBCAPTION_SCHEDULER_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "caption.h"
+#include "cea708.h"
+
+// EIA-608 is carried at two bytes per field per frame at 29.97, whatever the video frame rate is
+#define EIA608_PAIRS_PER_SECOND (30000.0 / 1001.0)
+#define CAPTION_SCHEDULER_SIZE 4096 // must be a power of 2
+
+typedef struct {
+    double fps;
+    double rate; //< field 1 cc_data per video frame
+    double credit; //< field 1 cc_data the line can carry, not yet sent
+    int cc_count; //< cc_data per video frame
+    size_t head;
+    size_t size;
+    uint16_t cc_data[CAPTION_SCHEDULER_SIZE];
+} caption_scheduler_t;
+
+/*! \brief Initializes a scheduler for video at fps frames per second
+    \param
+*/
+void caption_scheduler_init(caption_scheduler_t* sched, double fps);
+/*! \brief
+    \param
+*/
+static inline size_t caption_scheduler_size(caption_scheduler_t* sched) { return sched->size; }
+/*! \brief Queues count field 1 cc_data. Nothing is queued if there is not room for all of it
+    \param
+*/
+libcaption_stauts_t caption_scheduler_push(caption_scheduler_t* sched, const uint16_t* cc_data, size_t count);
+/*! \brief Queues the displayed memory of frame as a pop-on caption
+    \param
+*/
+libcaption_stauts_t caption_scheduler_push_frame(caption_scheduler_t* sched, caption_frame_t* frame);
+/*! \brief Queues the commands that turn the displayed memory of shown into that of frame
+    \param shown What decoders display once everything queued has been sent. It is updated
+*/
+libcaption_stauts_t caption_scheduler_push_delta(caption_scheduler_t* sched, caption_frame_t* shown, caption_frame_t* frame);
+/*! \brief Queues an erase of displayed memory
+    \param
+*/
+libcaption_stauts_t caption_scheduler_push_clear(caption_scheduler_t* sched);
+/*! \brief Returns the earliest time everything queued so far is on screen
+    \param timestamp presentation time of the next video frame, in seconds
+*/
+double caption_scheduler_display_time(caption_scheduler_t* sched, double timestamp);
+/*! \brief Fills cea708 with cc_count cc_data for the next video frame. Must be called once per frame
+    \param
+    Unused field 1 slots are padded with 0x8080, remaining slots are marked invalid.
+    Returns the number of queued cc_data that were sent
+*/
+int caption_scheduler_next(caption_scheduler_t* sched, cea708_t* cea708);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -33,6 +33,7 @@ extern "C" {
 // timestamp and duration are in seconds
 typedef struct _srt_t {
     struct _srt_t* next;
+    struct _srt_t* arena; // first cue of the block this cue shares with others, 0 if allocated alone
     double timestamp;
     double duration;
     size_t aloc;
@@ -40,21 +41,68 @@ typedef struct _srt_t {
 
 /*! \brief
     \param
+
+    Returns 0, leaving prev and head untouched, if the allocation fails.
 */
 srt_t* srt_new(const utf8_char_t* data, size_t size, double timestamp, srt_t* prev, srt_t** head);
-/*! \brief
+/*! \brief Frees the first cue of a list and returns the next one
     \param
+
+    Cues returned by srt_parse share one allocation, they are only released by srt_free.
 */
 srt_t* srt_free_head(srt_t* head);
 // returns the head of the link list. must bee freed when done
-/*! \brief
-    \param
+/*! \brief Parses an SRT document in a single pass
+    \param size bytes of data to parse, parsing also stops at a null terminator
+
+    All cues are allocated from one block, release them with srt_free.
 */
 srt_t* srt_parse(const utf8_char_t* data, size_t size);
+/*! \brief Parses a WebVTT document in a single pass, into the same cues as srt_parse
+    \param size bytes of data to parse, parsing also stops at a null terminator
+
+    Returns 0 if the WEBVTT header is missing. The header, NOTE, STYLE and REGION blocks, cue
+    identifiers and cue settings are skipped, cue text is kept as is. Release with srt_free.
+*/
+srt_t* vtt_parse(const utf8_char_t* data, size_t size);
 /*! \brief
     \param
 */
 void srt_free(srt_t* srt);
+////////////////////////////////////////////////////////////////////////////////
+// Incremental parser, for input that arrives a piece at a time
+#define SRT_PARSER_MAX_CUE_SIZE 4096 // text beyond this is dropped
+typedef struct {
+    int state;
+    int blank; // current line is whitespace so far
+    int keep_pair; // current line is cue text, so the rest of its line ending belongs to the cue
+    utf8_char_t pair; // second byte of a two byte line ending, if it may still arrive
+    double str_pts, end_pts;
+    size_t line; // start of the current line in data
+    size_t size;
+    utf8_char_t data[SRT_PARSER_MAX_CUE_SIZE];
+} srt_parser_t;
+
+/*! \brief
+    \param
+*/
+void srt_parser_init(srt_parser_t* parser);
+/*! \brief Parses the next piece of an SRT document
+    \param data any number of bytes, lines and line endings may be split between calls
+    \param prev last cue returned, new cues are appended after it. May be 0
+    \param head set to the first new cue if it is 0
+
+    A cue is returned as soon as the empty line that ends it arrives. Cues are allocated
+    with srt_new, so may be released one at a time with srt_free_head.
+    Returns the last cue appended, or prev if no cue was completed.
+*/
+srt_t* srt_parser_push(srt_parser_t* parser, const utf8_char_t* data, size_t size, srt_t* prev, srt_t** head);
+/*! \brief Ends the document, returning the final cue if it was not followed by an empty line
+    \param
+
+    The parser is ready for a new document afterwards.
+*/
+srt_t* srt_parser_flush(srt_parser_t* parser, srt_t* prev, srt_t** head);
 
 /*! \brief
     \param
@@ -75,6 +123,72 @@ int srt_to_caption_frame(srt_t* srt, caption_frame_t* frame);
     \param
 */
 srt_t* srt_from_caption_frame(caption_frame_t* frame, srt_t* prev, srt_t** head);
+////////////////////////////////////////////////////////////////////////////////
+// Cues sorted by start time, for lookups by time. Cues may overlap
+typedef struct {
+    double start;
+    double end_max; // latest end time of this and every earlier entry
+    srt_t* srt;
+} srt_index_entry_t;
+
+typedef struct {
+    size_t size;
+    size_t aloc;
+    srt_index_entry_t* entry;
+} srt_index_t;
+
+/*! \brief
+    \param
+*/
+void srt_index_init(srt_index_t* index);
+/*! \brief Frees the index, but not the cues in it
+    \param
+*/
+void srt_index_free(srt_index_t* index);
+/*! \brief Empties the index, keeping its memory
+    \param
+*/
+static inline void srt_index_clear(srt_index_t* index) { index->size = 0; }
+/*! \brief Adds every cue from head onward
+    \param
+
+    Sorts once at the end if the list was not already in order. Returns 0 if out of memory
+*/
+int srt_index_build(srt_index_t* index, srt_t* head);
+/*! \brief Adds one cue
+    \param
+
+    Cheap when cues are added in order, as they come from srt_parser_t. Returns 0 if out of memory
+*/
+int srt_index_add(srt_index_t* index, srt_t* srt);
+/*! \brief Returns the cue showing at timestamp, or 0
+    \param
+
+    If several overlap, the one that started last is returned
+*/
+srt_t* srt_index_at(const srt_index_t* index, double timestamp);
+/*! \brief Returns the first cue that starts at or after timestamp, or 0
+    \param
+*/
+srt_t* srt_index_next(const srt_index_t* index, double timestamp);
+/*! \brief Finds the cues that show at some point in [start, end)
+    \param cues receives up to max cues, in start order
+
+    Returns the number of cues found, which may be more than max
+*/
+size_t srt_index_query(const srt_index_t* index, double start, double end, srt_t** cues, size_t max);
+/*! \brief Writes every cue from srt onward as an SRT document
+    \param
+
+    Flushes the writer when done, returns 1 if everything was written
+*/
+int srt_write(srt_t* srt, utf8_writer_t* writer);
+/*! \brief Writes every cue from srt onward as a WebVTT document
+    \param
+
+    Flushes the writer when done, returns 1 if everything was written
+*/
+int vtt_write(srt_t* srt, utf8_writer_t* writer);
 /*! \brief
     \param
 */
@@ -83,6 +197,58 @@ void srt_dump(srt_t* srt);
     \param
 */
 void vtt_dump(srt_t* srt);
+////////////////////////////////////////////////////////////////////////////////
+// WebVTT segments for HLS
+/*! \brief Receives each finished segment
+    \param start start of the segment, in seconds. Segment n starts at n * the target duration
+    \param data complete WebVTT document of the segment
+
+    Return 0 to stop segmenting.
+*/
+typedef int (*vtt_segment_callback_t)(void* opaque, unsigned sequence, double start, double duration, const utf8_char_t* data, size_t size);
+
+typedef struct {
+    double duration; // target duration of a segment
+    int64_t mpegts; // 90kHz MPEG-TS timestamp of cue time zero, for X-TIMESTAMP-MAP
+    int split; // clip cues to each segment they overlap, instead of repeating them whole
+    unsigned sequence;
+    double end; // latest cue end seen
+    vtt_segment_callback_t callback;
+    void* opaque;
+    srt_t* carry; // copies of cues that continue past the current segment
+    int error;
+    size_t size;
+    size_t aloc;
+    utf8_char_t* data; // current segment
+} vtt_segmenter_t;
+
+/*! \brief
+    \param duration target segment duration, in seconds
+    \param mpegts the MPEG-TS timestamp (90kHz, not negative) the media has at cue time zero
+
+    Cues crossing a segment boundary are repeated in every segment they overlap with their
+    original timing, as HLS players expect. Set split to write only the part that overlaps.
+*/
+void vtt_segmenter_init(vtt_segmenter_t* seg, double duration, int64_t mpegts, vtt_segment_callback_t callback, void* opaque);
+/*! \brief Adds one cue, cues must be pushed in start order
+    \param
+
+    Every segment that ends before the cue starts is finished and passed to the callback,
+    including segments without cues. The cue is copied if it is needed later, so it may be
+    freed once this returns. Cues from srt_from_caption_frame can be pushed as soon as the
+    next one is created, which sets their duration. Returns 0 on error, or if the callback did.
+*/
+int vtt_segmenter_push(vtt_segmenter_t* seg, srt_t* srt);
+/*! \brief Finishes every remaining segment up to end
+    \param end end of the media, in seconds. If 0, the end of the last cue
+
+    The last segment is shortened to end there.
+*/
+int vtt_segmenter_finish(vtt_segmenter_t* seg, double end);
+/*! \brief
+    \param
+*/
+void vtt_segmenter_free(vtt_segmenter_t* seg);
 
 #ifdef __cplusplus
 }
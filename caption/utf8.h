@@ -29,6 +29,8 @@ extern "C" {
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 // These types exist to make the code more self dcoumenting
 // utf8_char_t point is a null teminate string of utf8 encodecd chars
@@ -112,6 +114,60 @@ int utf8_line_count(const utf8_char_t* data);
 #define UFTF_DEFAULT_MAX_FILE_SIZE = (50 * 1024 * 1024);
 
 utf8_char_t* utf8_load_text_file(const char* path, size_t* size);
+/*! \brief Maps a file into memory read only, instead of copying it to the heap
+    \param size out, the size of the file
+
+    There is no size limit. The view is not null terminated, so pass size along to the parsers,
+    which all stop at size. Returns 0 if the file can not be mapped, an empty file gives an
+    empty string. Release with utf8_unmap_text_file.
+*/
+const utf8_char_t* utf8_map_text_file(const char* path, size_t* size);
+/*! \brief
+    \param
+*/
+void utf8_unmap_text_file(const utf8_char_t* data, size_t size);
+////////////////////////////////////////////////////////////////////////////////
+// Buffered output, to a caller supplied buffer, a FILE* or a callback
+#define UTF8_WRITER_BUFFER_SIZE (16 * 1024)
+// returns the number of bytes consumed, anything less than size is an error
+typedef size_t (*utf8_writer_callback_t)(void* opaque, const utf8_char_t* data, size_t size);
+typedef struct {
+    utf8_writer_callback_t callback; // 0 when writing to a caller buffer
+    void* opaque;
+    utf8_char_t* data;
+    size_t size;
+    size_t used;
+    size_t total; // bytes written so far, including any that did not fit a caller buffer
+    int error;
+    utf8_char_t buffer[UTF8_WRITER_BUFFER_SIZE];
+} utf8_writer_t;
+
+/*! \brief Writes into data, which is kept null terminated
+    \param size of data in bytes, including room for the terminator
+
+    Output that does not fit is dropped and sets error, total still counts it
+*/
+void utf8_writer_init_buffer(utf8_writer_t* writer, utf8_char_t* data, size_t size);
+/*! \brief
+    \param
+*/
+void utf8_writer_init_file(utf8_writer_t* writer, FILE* file);
+/*! \brief
+    \param
+*/
+void utf8_writer_init_callback(utf8_writer_t* writer, utf8_writer_callback_t callback, void* opaque);
+/*! \brief
+    \param
+*/
+void utf8_writer_write(utf8_writer_t* writer, const utf8_char_t* data, size_t size);
+/*! \brief Hands anything buffered to the file or callback
+    \return 1 if everything written so far was accepted
+*/
+int utf8_writer_flush(utf8_writer_t* writer);
+/*! \brief
+    \param
+*/
+static inline void utf8_writer_puts(utf8_writer_t* writer, const utf8_char_t* data) { utf8_writer_write(writer, data, strlen(data)); }
 
 #ifdef __cplusplus
 }
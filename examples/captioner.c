@@ -21,7 +21,8 @@
 /* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
 /* THE SOFTWARE.                                                                              */
 /**********************************************************************************************/
-#include "caption.h"
+#include "avc.h"
+#include "encoder.h"
 #include "flv.h"
 #include <errno.h>
 #include <fcntl.h>
@@ -32,7 +33,7 @@
 #include <unistd.h>
 
 char charcode[] = {
-    0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', 0, 0,
+    0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b', 0,
     'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '[', ']', '\n', 0, 'A', 'S',
     'D', 'F', 'G', 'H', 'J', 'K', 'L', ';', '\'', '`', 0, '\\', 'Z', 'X', 'C', 'V',
     'B', 'N', 'M', ',', '.', '/', 0, '*', 0, ' ', 0, 0, 0, 0, 0, 0,
@@ -49,17 +50,20 @@ int data_ready(int fd)
     return (0 < cnt);
 }
 
-#define MAX_CAP_LENGTH (SCREEN_ROWS * SCREEN_COLS)
+#define FRAME_RATE (30000.0 / 1001.0)
+
 int main(int argc, char** argv)
 {
-    int fd;
+    int fd, pending = 0;
     ssize_t n;
+    sei_t sei;
     flvtag_t tag;
     struct input_event ev;
     int has_audio, has_video;
     const char* dev = argv[1];
-    char text[MAX_CAP_LENGTH + 1];
-    memset(text, 0, MAX_CAP_LENGTH + 1);
+    caption_encoder_t enc;
+    caption_scheduler_t sched;
+    char text[2] = { 0, 0 };
 
     FILE* flv = flv_open_read("-");
     FILE* out = flv_open_write("-");
@@ -80,6 +84,8 @@ int main(int argc, char** argv)
     }
 
     flvtag_init(&tag);
+    caption_encoder_init(&enc, caption_encoder_roll_up_3);
+    caption_scheduler_init(&sched, 2 < argc ? atof(argv[2]) : FRAME_RATE);
 
     while (flv_read_tag(flv, &tag)) {
         if (flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
@@ -97,17 +103,22 @@ int main(int argc, char** argv)
                     break;
                 }
 
-                int len = strlen(text);
-                char c = (EV_KEY == ev.type && 1 == ev.value && ev.code < 64) ? charcode[ev.code] : 0;
+                text[0] = (EV_KEY == ev.type && 1 == ev.value && ev.code < 64) ? charcode[ev.code] : 0;
 
-                if (0 < len && '\n' == c) {
-                    fprintf(stderr, "='%s'\n", text);
-                    flvtag_addcaption(&tag, text);
-                    memset(text, 0, MAX_CAP_LENGTH + 1);
-                } else if (0 != c && len < MAX_CAP_LENGTH) {
-                    text[len] = c;
+                // every keystroke goes out as soon as the line has room for it
+                if (0 != text[0]) {
+                    pending = (LIBCAPTION_OK != caption_encoder_push(&enc, &sched, text));
                 }
             }
+
+            if (pending) {
+                pending = (LIBCAPTION_OK != caption_encoder_push(&enc, &sched, ""));
+            }
+
+            sei_init(&sei);
+            sei_from_caption_scheduler(&sei, &sched);
+            flvtag_mergesei(&tag, &sei);
+            sei_free(&sei);
         }
 
         flv_write_tag(out, &tag);
@@ -24,11 +24,17 @@
 #include "flv.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define SEI_CACHE_SIZE 64
 
 int main(int argc, char** argv)
 {
     flvtag_t tag;
-    scc_t* scc = NULL;
+    flv_map_t map;
+    FILE* flv = NULL;
+    scc_t* scc;
+    scc_reader_t reader;
     size_t scc_size = 0;
 
     if (4 > argc) {
@@ -36,17 +42,20 @@ int main(int argc, char** argv)
         exit(EXIT_FAILURE);
     }
 
-    FILE* flv = flv_open_read(argv[1]);
-    utf8_char_t* scc_data_ptr = utf8_load_text_file(argv[2], &scc_size);
-    utf8_char_t* scc_data = scc_data_ptr;
+    // Map regular files, so tags that pass through are never copied
+    if (!flv_map_open(&map, argv[1])) {
+        flv = flv_open_read(argv[1]);
+    }
+
+    const utf8_char_t* scc_data = utf8_map_text_file(argv[2], &scc_size);
     FILE* out = flv_open_write(argv[3]);
 
-    if (!flv) {
+    if (!flv && !map.data) {
         fprintf(stderr, "Falule to open input flv '%s'\n", argv[1]);
         exit(EXIT_FAILURE);
     }
 
-    if (!scc_data) {
+    if (!scc_data || !scc_reader_init(&reader, scc_data, scc_size)) {
         fprintf(stderr, "Falule to open input scc '%s'\n", argv[2]);
         exit(EXIT_FAILURE);
     }
@@ -57,9 +66,13 @@ int main(int argc, char** argv)
     }
 
     int has_audio, has_video;
+    sei_cache_t cache;
+    const uint8_t* nalu;
+    size_t nalu_size;
     flvtag_init(&tag);
+    sei_cache_init(&cache, SEI_CACHE_SIZE);
 
-    if (!flv_read_header(flv, &has_audio, &has_video)) {
+    if (!(flv ? flv_read_header(flv, &has_audio, &has_video) : flv_map_read_header(&map, &has_audio, &has_video))) {
         fprintf(stderr, "%s is not an flv file\n", argv[1]);
         return EXIT_FAILURE;
     }
@@ -67,20 +80,25 @@ int main(int argc, char** argv)
     flv_write_header(out, has_audio, has_video);
 
     // read the first scc
-    scc_data += scc_to_608(&scc, scc_data);
+    scc = scc_reader_next(&reader);
 
-    while (flv_read_tag(flv, &tag)) {
+    while (flv ? flv_read_tag(flv, &tag) : flv_map_read_tag(&map, &tag)) {
         double timestamp = flvtag_pts_seconds(&tag);
 
-        if (scc && scc->cc_size && scc->timestamp < timestamp && flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
-            flvtag_addcaption_scc(&tag, scc);
-            scc_data += scc_to_608(&scc, scc_data);
+        if (scc && scc->timestamp < timestamp && flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
+            nalu = sei_cache_render_scc(&cache, scc, &nalu_size);
+            flv_writev_seinalu(out, &tag, nalu, nalu_size);
+            scc = scc_reader_next(&reader);
+        } else {
+            flv_writev_tag(out, &tag, NULL);
         }
-
-        flv_write_tag(out, &tag);
     }
 
-    free(scc_data_ptr);
+    fprintf(stderr, "SEI cache: %u hits, %u misses\n", sei_cache_hits(&cache), sei_cache_misses(&cache));
+    sei_cache_free(&cache);
+    scc_reader_free(&reader);
+    utf8_unmap_text_file(scc_data, scc_size);
     flvtag_free(&tag);
+    flv_map_close(&map);
     return EXIT_SUCCESS;
 }
@@ -26,89 +26,116 @@
 #include "srt.h"
 
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-#define MAX_SRT_SIZE (1 * 1024 * 1024)
+#define MAX_READ_SIZE (64 * 1024)
+#define SEI_CACHE_SIZE 64
+#define SEEK_THRESHOLD 1.0 // a gap between video frames larger than this, in seconds, is treated as a seek
 
-// retunes number of bytes read
-// negative number on error
-// retursn 0 on 'not ready' and 'eof'
-// eof set to 1 on end, otherwise zero
-size_t fd_read(int fd, uint8_t* data, size_t size, int* eof)
+// Captions arrive on fd as SRT documents separated by a NULL byte (or end of file)
+typedef struct {
+    int fd;
+    int eof;
+    int restart; // the next cue starts a new document
+    size_t size; // bytes buffered
+    size_t used; // bytes already given to the parser
+    srt_t* last; // last cue of the current document
+    srt_parser_t parser;
+    utf8_char_t data[MAX_READ_SIZE];
+} srt_input_t;
+
+void srt_input_init(srt_input_t* in, int fd)
 {
-    fd_set rfds;
-    struct timeval tv;
-    int retval;
-
-    (*eof) = 0;
-    FD_ZERO(&rfds);
-    FD_SET(fd, &rfds);
-    tv.tv_sec = 0;
-    tv.tv_usec = 1;
-    retval = select(fd + 1, &rfds, NULL, NULL, &tv);
-
-    if (0 > retval) {
-        return retval;
-    }
-
-    // not ready
-    if (!(retval && FD_ISSET(fd, &rfds))) {
-        return 0;
-    }
-
-    retval = read(fd, data, size);
-
-    if (0 == retval) {
-        (*eof) = 1;
-    }
-
-    return retval;
+    in->fd = fd;
+    in->eof = 0;
+    in->restart = 1;
+    in->size = 0;
+    in->used = 0;
+    in->last = 0;
+    srt_parser_init(&in->parser);
 }
 
-size_t g_srt_size = 0;
-utf8_char_t g_srt_data[MAX_SRT_SIZE];
-srt_t* srt_from_fd(int fd)
+// Never blocks. Parses whatever is available and returns the cues it completed, linked after
+// the previous cues of the same document. restart is set if they begin a new document
+srt_t* srt_from_input(srt_input_t* in, int* restart)
 {
-    int eof;
-    uint8_t c;
+    srt_t* head = 0;
+    int terminated = 0;
 
     for (;;) {
-        int ret = fd_read(fd, &c, 1, &eof);
+        if (in->used < in->size) {
+            utf8_char_t* end = memchr(&in->data[in->used], '\0', in->size - in->used);
+            size_t size = end ? (size_t)(end - &in->data[in->used]) : in->size - in->used;
+            in->last = srt_parser_push(&in->parser, &in->data[in->used], size, in->last, &head);
+            in->used += size;
+
+            if (end) {
+                // anything after the terminator belongs to the next document
+                in->last = srt_parser_flush(&in->parser, in->last, &head);
+                in->used += 1;
+                terminated = 1;
+                break;
+            }
+        }
+
+        struct pollfd pfd = { in->fd, POLLIN, 0 };
 
-        if (eof || (1 == ret && 0 == c)) {
-            srt_t* srt = srt_parse(&g_srt_data[0], g_srt_size);
-            g_srt_size = 0;
-            return srt;
+        if (in->eof || 0 >= poll(&pfd, 1, 0)) {
+            break;
         }
 
-        if (1 == ret) {
-            if (g_srt_size >= MAX_SRT_SIZE - 1) {
-                fprintf(stderr, "Warning MAX_SRT_SIZE reached. Clearing buffer\n");
-                g_srt_size = 0;
-            }
+        ssize_t bytes = read(in->fd, &in->data[0], MAX_READ_SIZE);
 
-            g_srt_data[g_srt_size] = c;
-            g_srt_size += 1;
-        } else {
-            return 0;
+        if (0 > bytes) {
+            break;
         }
+
+        in->size = bytes;
+        in->used = 0;
+
+        if (0 == bytes) {
+            // end of file also ends the document
+            in->eof = 1;
+            in->last = srt_parser_flush(&in->parser, in->last, &head);
+            break;
+        }
+    }
+
+    (*restart) = head && in->restart;
+
+    if (terminated) {
+        in->restart = 1;
+        in->last = 0;
+    } else if (head) {
+        in->restart = 0;
     }
+
+    return head;
 }
 
 int main(int argc, char** argv)
 {
     flvtag_t tag;
-    srt_t *old_srt = 0, *nxt_srt = 0;
-    double timestamp, offset = 0, clear_timestamp = 0;
+    srt_t *old_srt = 0, *nxt_srt = 0, *srt;
+    srt_index_t index;
+    double timestamp, offset = 0, clear_timestamp = 0, last_dts = -1;
     int has_audio, has_video;
     FILE* flv = flv_open_read(argv[1]);
     int fd = open(argv[2], O_RDWR);
     FILE* out = flv_open_write(argv[3]);
+    srt_input_t* in = (srt_input_t*)malloc(sizeof(srt_input_t));
+    sei_cache_t cache;
+    const uint8_t* nalu;
+    size_t nalu_size;
 
     flvtag_init(&tag);
+    sei_cache_init(&cache, SEI_CACHE_SIZE);
+    srt_input_init(in, fd);
+    srt_index_init(&index);
 
     if (!flv_read_header(flv, &has_audio, &has_video)) {
         fprintf(stderr, "%s is not an flv file\n", argv[1]);
@@ -123,35 +150,63 @@ int main(int argc, char** argv)
 
     while (flv_read_tag(flv, &tag)) {
 
-        srt_t* new_srt = srt_from_fd(fd);
+        int restart;
+        srt_t* new_srt = srt_from_input(in, &restart);
         timestamp = flvtag_pts_seconds(&tag);
 
-        if (new_srt) {
+        if (restart) {
             fprintf(stderr, "Loaded new SRT at time %f\n", timestamp);
             srt_free(old_srt);
+            srt_index_clear(&index);
             old_srt = new_srt;
             nxt_srt = new_srt;
             offset = timestamp;
             clear_timestamp = timestamp;
+        } else if (new_srt && !nxt_srt) {
+            // new cues are already linked after the last one, but we had run out
+            nxt_srt = new_srt;
+        }
+
+        for (srt = new_srt; srt; srt = srt_next(srt)) {
+            srt_index_add(&index, srt);
         }
 
         if (flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
+            double dts = flvtag_dts_seconds(&tag);
+
+            if (0 <= last_dts && !restart && (dts < last_dts || last_dts + SEEK_THRESHOLD < dts)) {
+                // Playback jumped, carry on from whatever cue belongs at the new position
+                fprintf(stderr, "T: %0.02f: seek from %0.02f\n", timestamp, last_dts);
+                srt = srt_index_at(&index, timestamp - offset);
+                nxt_srt = srt ? srt : srt_index_next(&index, timestamp - offset);
+                clear_timestamp = timestamp;
+            }
+
+            last_dts = dts;
             if (nxt_srt && (offset + nxt_srt->timestamp) <= timestamp) {
                 fprintf(stderr, "T: %0.02f (%0.02fs):\n%s\n", (offset + nxt_srt->timestamp), nxt_srt->duration, srt_data(nxt_srt));
                 clear_timestamp = (offset + nxt_srt->timestamp) + nxt_srt->duration;
-                flvtag_addcaption_text(&tag, srt_data(nxt_srt));
+                nalu = sei_cache_render_text(&cache, srt_data(nxt_srt), &nalu_size);
+                flv_writev_seinalu(out, &tag, nalu, nalu_size);
                 nxt_srt = nxt_srt->next;
+                continue;
             } else if (0 <= clear_timestamp && clear_timestamp <= timestamp) {
                 fprintf(stderr, "T: %0.02f: [CAPTIONS CLEARED]\n", timestamp);
-                flvtag_addcaption_text(&tag, NULL);
+                nalu = sei_cache_render_text(&cache, NULL, &nalu_size);
+                flv_writev_seinalu(out, &tag, nalu, nalu_size);
                 clear_timestamp = -1;
+                continue;
             }
         }
 
-        flv_write_tag(out, &tag);
+        flv_writev_tag(out, &tag, NULL);
     }
 
+    fprintf(stderr, "SEI cache: %u hits, %u misses\n", sei_cache_hits(&cache), sei_cache_misses(&cache));
+    sei_cache_free(&cache);
+    srt_index_free(&index);
     srt_free(old_srt);
+    free(in);
     flvtag_free(&tag);
     flv_close(flv);
     flv_close(out);
@@ -22,8 +22,14 @@
 /* THE SOFTWARE.                                                                              */
 /**********************************************************************************************/
 #include "flv.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 void flvtag_init(flvtag_t* tag)
 {
@@ -32,8 +38,9 @@ void flvtag_init(flvtag_t* tag)
 
 void flvtag_free(flvtag_t* tag)
 {
-    if (tag->data) {
-        free(tag->data);
+    // views are owned by the map they were read from
+    if (tag->data && tag->aloc) {
+        free(tag->data - tag->head);
     }
 
     flvtag_init(tag);
@@ -50,14 +57,42 @@ int flvtag_reserve(flvtag_t* tag, uint32_t size)
 {
     size += FLV_TAG_HEADER_SIZE + FLV_TAG_FOOTER_SIZE;
 
-    if (size > tag->aloc) {
-        tag->data = realloc(tag->data, size);
+    if (flvtag_is_view(tag)) {
+        // copy on write
+        size_t raw_size = flvtag_raw_size(tag);
+        uint8_t* data = malloc(size > raw_size ? size : raw_size);
+        memcpy(data, tag->data, raw_size);
+        tag->data = data;
+        tag->aloc = size > raw_size ? size : raw_size;
+    } else if (size > tag->aloc) {
+        uint8_t* base = realloc(tag->data ? tag->data - tag->head : 0, tag->head + size);
+        tag->data = base + tag->head;
         tag->aloc = size;
     }
 
     return 1;
 }
 
+// Like flvtag_reserve(), but also makes sure there are head free bytes in front of the data.
+// Existing contents are not preserved
+static int flvtag_reserve_headroom(flvtag_t* tag, size_t head, uint32_t size)
+{
+    size += FLV_TAG_HEADER_SIZE + FLV_TAG_FOOTER_SIZE;
+    uint8_t* base = tag->data ? tag->data - tag->head : 0;
+    size_t total = tag->head + tag->aloc;
+
+    if (head + size > total) {
+        free(base);
+        base = malloc(head + size);
+        total = head + size;
+    }
+
+    tag->data = base + head;
+    tag->head = head;
+    tag->aloc = total - head;
+    return 1;
+}
+
 FILE* flv_open_read(const char* flv)
 {
     if (0 == flv || 0 == strcmp("-", flv)) {
@@ -114,8 +149,12 @@ int flv_read_tag(FILE* flv, flvtag_t* tag)
         return 0;
     }
 
+    if (flvtag_is_view(tag)) {
+        flvtag_init(tag);
+    }
+
     size = ((h[1] << 16) | (h[2] << 8) | h[3]);
-    flvtag_reserve(tag, size);
+    flvtag_reserve_headroom(tag, FLVTAG_HEADROOM, size);
     // copy header to buffer
     memcpy(tag->data, &h[0], FLV_TAG_HEADER_SIZE);
 
@@ -132,6 +171,83 @@ int flv_write_tag(FILE* flv, flvtag_t* tag)
     return size == fwrite(flvtag_raw_data(tag), 1, size, flv);
 }
 ////////////////////////////////////////////////////////////////////////////////
+int flv_map_open(flv_map_t* map, const char* path)
+{
+    struct stat st;
+    memset(map, 0, sizeof(flv_map_t));
+    int fd = (0 == path || 0 == strcmp("-", path)) ? -1 : open(path, O_RDONLY);
+
+    if (0 > fd) {
+        return 0;
+    }
+
+    if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode) || 0 == st.st_size) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping holds its own reference
+
+    if (MAP_FAILED == data) {
+        return 0;
+    }
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    map->data = (uint8_t*)data;
+    map->size = st.st_size;
+    return 1;
+}
+
+void flv_map_close(flv_map_t* map)
+{
+    if (map->data) {
+        munmap(map->data, map->size);
+    }
+
+    memset(map, 0, sizeof(flv_map_t));
+}
+
+int flv_map_read_header(flv_map_t* map, int* has_audio, int* has_video)
+{
+    const uint8_t* h = map->data;
+
+    if (FLV_HEADER_SIZE > map->size || 'F' != h[0] || 'L' != h[1] || 'V' != h[2]) {
+        return 0;
+    }
+
+    (*has_audio) = h[4] & 0x04;
+    (*has_video) = h[4] & 0x01;
+    map->pos = FLV_HEADER_SIZE;
+    return 1;
+}
+
+int flv_map_read_tag(flv_map_t* map, flvtag_t* tag)
+{
+    const uint8_t* h = &map->data[map->pos];
+
+    if (FLV_TAG_HEADER_SIZE > map->size - map->pos) {
+        return 0;
+    }
+
+    size_t size = FLV_TAG_HEADER_SIZE + ((h[1] << 16) | (h[2] << 8) | h[3]) + FLV_TAG_FOOTER_SIZE;
+
+    if (size > map->size - map->pos) {
+        return 0;
+    }
+
+    flvtag_free(tag);
+    tag->data = (uint8_t*)h;
+    tag->aloc = 0;
+    map->pos += size;
+    return 1;
+}
+
+int flvtag_own(flvtag_t* tag)
+{
+    return flvtag_is_view(tag) ? flvtag_reserve(tag, flvtag_size(tag)) : 1;
+}
+////////////////////////////////////////////////////////////////////////////////
 size_t flvtag_header_size(flvtag_t* tag)
 {
     switch (flvtag_type(tag)) {
@@ -338,12 +454,82 @@ int flvtag_avcwritesei(flvtag_t* tag, sei_t* sei)
     return 1;
 }
 
+// Returns the offset into tag->data where a caption SEI belongs, after any leading
+// AUD, SPS and PPS. Returns 0 if the tag already carries an SEI NALU, or is malformed
+static size_t flvtag_sei_offset(flvtag_t* tag)
+{
+    size_t offset = 0;
+    uint8_t* data = flvtag_payload_data(tag);
+    ssize_t size = flvtag_payload_size(tag);
+
+    while (LENGTH_SIZE < size) {
+        uint8_t nalu_type = data[LENGTH_SIZE] & 0x1F;
+        uint32_t nalu_size = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+
+        if (6 == nalu_type) {
+            return 0;
+        }
+
+        if (!offset && 7 != nalu_type && 8 != nalu_type && 9 != nalu_type) {
+            offset = data - tag->data;
+        }
+
+        data += LENGTH_SIZE + nalu_size;
+        size -= LENGTH_SIZE + nalu_size;
+    }
+
+    return 0 == size ? (offset ? offset : (size_t)(data - tag->data)) : 0;
+}
+
+// Inserts the SEI into the tags headroom. Only the tag header and any leading
+// parameter sets are moved
+static int flvtag_insertnalu(flvtag_t* tag, const uint8_t* nalu_data, size_t nalu_size)
+{
+    size_t offset = flvtag_sei_offset(tag);
+    size_t insert = LENGTH_SIZE + nalu_size;
+
+    if (!offset || !nalu_size || insert > tag->head) {
+        return 0;
+    }
+
+    uint32_t flvsize = flvtag_size(tag);
+    uint8_t* data = tag->data - insert;
+    memmove(data, tag->data, offset);
+    data[offset + 0] = nalu_size >> 24; // nalu size
+    data[offset + 1] = nalu_size >> 16;
+    data[offset + 2] = nalu_size >> 8;
+    data[offset + 3] = nalu_size >> 0;
+    memcpy(&data[offset + LENGTH_SIZE], nalu_data, nalu_size);
+    tag->data = data;
+    tag->head -= insert;
+    tag->aloc += insert;
+    flvtag_updatesize(tag, flvsize + insert);
+    return 1;
+}
+
+static int flvtag_insertsei(flvtag_t* tag, sei_t* sei)
+{
+    uint8_t sei_data[FLVTAG_HEADROOM];
+    size_t sei_size = sei_render_size(sei);
+
+    if (!sei_size || LENGTH_SIZE + sei_size > tag->head || !flvtag_sei_offset(tag)) {
+        return 0;
+    }
+
+    sei_size = sei_render(sei, &sei_data[0]);
+    return flvtag_insertnalu(tag, &sei_data[0], sei_size);
+}
+
 int flvtag_addsei(flvtag_t* tag, sei_t* sei)
 {
     if (flvtag_avcpackettype_nalu != flvtag_avcpackettype(tag)) {
         return 0;
     }
 
+    if (flvtag_insertsei(tag, sei)) {
+        return 1;
+    }
+
     sei_t new_sei;
     sei_init(&new_sei);
     sei_cat(&new_sei, sei, 1);
@@ -383,18 +569,101 @@ int flvtag_addsei(flvtag_t* tag, sei_t* sei)
     return 1;
 }
 
-int flvtag_addcaption_text(flvtag_t* tag, const utf8_char_t* text)
+// Replaces the nalu_size bytes at offset (the NALU length field) with a new NALU.
+// Views are copied first
+static int flvtag_replacenalu(flvtag_t* tag, size_t offset, size_t old_size, const uint8_t* nalu_data, size_t nalu_size)
 {
-    sei_t sei;
-    sei_init(&sei);
+    uint32_t flvsize = flvtag_size(tag);
+    size_t tail = offset + LENGTH_SIZE + old_size;
+    uint32_t new_size = flvsize + nalu_size - old_size;
+
+    if (old_size != nalu_size || flvtag_is_view(tag)) {
+        flvtag_reserve(tag, new_size > flvsize ? new_size : flvsize);
+        memmove(&tag->data[offset + LENGTH_SIZE + nalu_size], &tag->data[tail], FLV_TAG_HEADER_SIZE + flvsize - tail);
+    }
+
+    tag->data[offset + 0] = nalu_size >> 24; // nalu size
+    tag->data[offset + 1] = nalu_size >> 16;
+    tag->data[offset + 2] = nalu_size >> 8;
+    tag->data[offset + 3] = nalu_size >> 0;
+    memcpy(&tag->data[offset + LENGTH_SIZE], nalu_data, nalu_size);
+    flvtag_updatesize(tag, new_size);
+    return 1;
+}
+
+int flvtag_mergesei(flvtag_t* tag, sei_t* sei)
+{
+    if (flvtag_avcpackettype_nalu != flvtag_avcpackettype(tag)) {
+        return 0;
+    }
+
+    uint8_t* data = flvtag_payload_data(tag);
+    ssize_t size = flvtag_payload_size(tag);
+
+    while (LENGTH_SIZE < size) {
+        uint32_t nalu_size = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+
+        if (nalu_size > size - LENGTH_SIZE) {
+            break;
+        }
+
+        if (6 == (data[LENGTH_SIZE] & 0x1F)) {
+            sei_t old_sei;
+            size_t offset = data - tag->data;
+
+            if (!sei_parse_nalu(&old_sei, &data[LENGTH_SIZE], nalu_size, flvtag_dts_seconds(tag), flvtag_cts_seconds(tag))) {
+                sei_free(&old_sei);
+                break;
+            }
+
+            // Without a GA94 message to merge into, carry ours in the same NALU
+            if (LIBCAPTION_OK != sei_merge_cea708(&old_sei, sei)) {
+                sei_cat(&old_sei, sei, 1);
+            }
+
+            uint8_t* sei_data = malloc(sei_render_size(&old_sei));
+            size_t sei_size = sei_render(&old_sei, sei_data);
+            int ret = sei_size && flvtag_replacenalu(tag, offset, nalu_size, sei_data, sei_size);
+            sei_free(&old_sei);
+            free(sei_data);
+            return ret;
+        }
+
+        data += LENGTH_SIZE + nalu_size;
+        size -= LENGTH_SIZE + nalu_size;
+    }
+
+    return flvtag_addsei(tag, sei);
+}
+
+static void flv_sei_from_text(sei_t* sei, const utf8_char_t* text)
+{
+    sei_init(sei);
 
     if (text) {
         caption_frame_t frame;
         caption_frame_init(&frame);
         caption_frame_from_text(&frame, text);
-        sei_from_caption_frame(&sei, &frame);
+        sei_from_caption_frame(sei, &frame);
     } else {
-        sei_from_caption_clear(&sei);
+        sei_from_caption_clear(sei);
+    }
+}
+
+int flvtag_addseinalu(flvtag_t* tag, const uint8_t* data, size_t size)
+{
+    if (flvtag_avcpackettype_nalu != flvtag_avcpackettype(tag)) {
+        return 0;
+    }
+
+    if (flvtag_insertnalu(tag, data, size)) {
+        return 1;
+    }
+
+    sei_t sei;
+    if (!sei_parse_nalu(&sei, data, size, 0.0, 0.0)) {
+        sei_free(&sei);
+        return 0;
     }
 
     int ret = flvtag_addsei(tag, &sei);
@@ -402,6 +671,15 @@ int flvtag_addcaption_text(flvtag_t* tag, const utf8_char_t* text)
     return ret;
 }
 
+int flvtag_addcaption_text(flvtag_t* tag, const utf8_char_t* text)
+{
+    sei_t sei;
+    flv_sei_from_text(&sei, text);
+    int ret = flvtag_addsei(tag, &sei);
+    sei_free(&sei);
+    return ret;
+}
+
 int flvtag_addcaption_scc(flvtag_t* tag, const scc_t* scc)
 {
     sei_t sei;
@@ -411,3 +689,132 @@ int flvtag_addcaption_scc(flvtag_t* tag, const scc_t* scc)
     sei_free(&sei);
     return ret;
 }
+////////////////////////////////////////////////////////////////////////////////
+static int flv_writev(int fd, struct iovec* iov, int count)
+{
+    while (0 < count) {
+        ssize_t bytes = writev(fd, iov, count);
+
+        if (0 > bytes && EINTR == errno) {
+            continue; // interrupted before anything was written
+        }
+
+        if (0 > bytes) {
+            return 0;
+        }
+
+        // skip what was written, and continue a partial write
+        for (; 0 < count && (size_t)bytes >= iov->iov_len; ++iov, --count) {
+            bytes -= iov->iov_len;
+        }
+
+        if (0 < count) {
+            iov->iov_base = (uint8_t*)iov->iov_base + bytes;
+            iov->iov_len -= bytes;
+        }
+    }
+
+    return 1;
+}
+
+// Splice the nalu into the tag at offset
+static int flv_writev_splice(FILE* flv, flvtag_t* tag, size_t offset, const uint8_t* nalu_data, size_t nalu_size)
+{
+    struct iovec iov[6];
+    uint8_t header[FLV_TAG_HEADER_SIZE];
+    uint8_t length[LENGTH_SIZE];
+    uint8_t footer[FLV_TAG_FOOTER_SIZE];
+
+    // anything buffered by fwrite must land before this tag
+    fflush(flv);
+
+    if (!nalu_size) {
+        iov[0].iov_base = tag->data;
+        iov[0].iov_len = flvtag_raw_size(tag);
+        return flv_writev(fileno(flv), &iov[0], 1);
+    }
+
+    uint32_t size = flvtag_size(tag) + LENGTH_SIZE + nalu_size;
+    memcpy(&header[0], tag->data, FLV_TAG_HEADER_SIZE);
+    header[1] = size >> 16; // DataSize
+    header[2] = size >> 8; // DataSize
+    header[3] = size >> 0; // DataSize
+    length[0] = nalu_size >> 24; // nalu size
+    length[1] = nalu_size >> 16;
+    length[2] = nalu_size >> 8;
+    length[3] = nalu_size >> 0;
+    size += FLV_TAG_HEADER_SIZE;
+    footer[0] = size >> 24; // PrevTagSize
+    footer[1] = size >> 16; // PrevTagSize
+    footer[2] = size >> 8; // PrevTagSize
+    footer[3] = size >> 0; // PrevTagSize
+
+    iov[0].iov_base = &header[0];
+    iov[0].iov_len = FLV_TAG_HEADER_SIZE;
+    iov[1].iov_base = tag->data + FLV_TAG_HEADER_SIZE;
+    iov[1].iov_len = offset - FLV_TAG_HEADER_SIZE;
+    iov[2].iov_base = &length[0];
+    iov[2].iov_len = LENGTH_SIZE;
+    iov[3].iov_base = (uint8_t*)nalu_data;
+    iov[3].iov_len = nalu_size;
+    iov[4].iov_base = tag->data + offset;
+    iov[4].iov_len = FLV_TAG_HEADER_SIZE + flvtag_size(tag) - offset;
+    iov[5].iov_base = &footer[0];
+    iov[5].iov_len = FLV_TAG_FOOTER_SIZE;
+    return flv_writev(fileno(flv), &iov[0], 6);
+}
+
+int flv_writev_tag(FILE* flv, flvtag_t* tag, sei_t* sei)
+{
+    uint8_t sei_data[FLVTAG_HEADROOM];
+    size_t offset = 0, sei_size = 0;
+
+    if (sei && flvtag_avcpackettype_nalu == flvtag_avcpackettype(tag)) {
+        offset = flvtag_sei_offset(tag);
+        sei_size = sei_render_size(sei);
+
+        // The tag already carries an SEI, or the SEI is unusually large. Fall back to rebuilding it
+        if (!offset || FLVTAG_HEADROOM < sei_size) {
+            return flvtag_addsei(tag, sei) && flv_write_tag(flv, tag);
+        }
+
+        sei_size = sei_render(sei, &sei_data[0]);
+    }
+
+    return flv_writev_splice(flv, tag, offset, &sei_data[0], sei_size);
+}
+
+int flv_writev_seinalu(FILE* flv, flvtag_t* tag, const uint8_t* data, size_t size)
+{
+    size_t offset = 0;
+
+    if (flvtag_avcpackettype_nalu == flvtag_avcpackettype(tag)) {
+        // The tag already carries an SEI, fall back to rebuilding it
+        if (!(offset = flvtag_sei_offset(tag))) {
+            return flvtag_addseinalu(tag, data, size) && flv_write_tag(flv, tag);
+        }
+    } else {
+        size = 0;
+    }
+
+    return flv_writev_splice(flv, tag, offset, data, size);
+}
+
+int flv_writev_caption_text(FILE* flv, flvtag_t* tag, const utf8_char_t* text)
+{
+    sei_t sei;
+    flv_sei_from_text(&sei, text);
+    int ret = flv_writev_tag(flv, tag, &sei);
+    sei_free(&sei);
+    return ret;
+}
+
+int flv_writev_caption_scc(FILE* flv, flvtag_t* tag, const scc_t* scc)
+{
+    sei_t sei;
+    sei_init(&sei);
+    sei_from_scc(&sei, scc);
+    int ret = flv_writev_tag(flv, tag, &sei);
+    sei_free(&sei);
+    return ret;
+}
@@ -34,9 +34,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "avc.h"
 ////////////////////////////////////////////////////////////////////////////////
+// Tags read with flv_read_tag() keep FLVTAG_HEADROOM free bytes in front of data,
+// so a caption SEI can be inserted without moving the rest of the payload
+#define FLVTAG_HEADROOM 2048
 typedef struct {
     uint8_t* data;
     size_t aloc;
+    size_t head; // free bytes in front of data
 } flvtag_t;
 
 void flvtag_init(flvtag_t* tag);
@@ -128,13 +132,44 @@ int flv_write_tag(FILE* flv, flvtag_t* tag);
 int flv_read_header(FILE* flv, int* has_audio, int* has_video);
 int flv_write_header(FILE* flv, int has_audio, int has_video);
 ////////////////////////////////////////////////////////////////////////////////
+// Memory mapped reader. Tags read from a map are views into the mapping (aloc is
+// zero), so nothing is copied until a tag is modified. Views are valid until
+// flv_map_close()
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t pos;
+} flv_map_t;
+
+int flv_map_open(flv_map_t* map, const char* path);
+void flv_map_close(flv_map_t* map);
+int flv_map_read_header(flv_map_t* map, int* has_audio, int* has_video);
+int flv_map_read_tag(flv_map_t* map, flvtag_t* tag);
+static inline int flvtag_is_view(flvtag_t* tag) { return tag->data && 0 == tag->aloc; }
+// Copies a view into an owned buffer. Does nothing if the tag is already owned
+int flvtag_own(flvtag_t* tag);
+////////////////////////////////////////////////////////////////////////////////
 // If the tage has more that on sei message, they will be combined into one
 sei_t* flv_read_sei(FILE* flv, flvtag_t* tag);
 ////////////////////////////////////////////////////////////////////////////////
 int flvtag_initavc(flvtag_t* tag, uint32_t dts, int32_t cts, flvtag_frametype_t type);
 int flvtag_avcwritenal(flvtag_t* tag, uint8_t* data, size_t size);
+int flvtag_addsei(flvtag_t* tag, sei_t* sei);
+// Like flvtag_addsei(), but if the tag already carries an SEI, the caption cc_data replaces
+// padding in its GA94 message so the tag keeps a single SEI of about the same size
+int flvtag_mergesei(flvtag_t* tag, sei_t* sei);
 int flvtag_addcaption_scc(flvtag_t* tag, const scc_t* scc);
 int flvtag_addcaption_text(flvtag_t* tag, const utf8_char_t* text);
+// data is a rendered SEI NALU, such as returned by sei_cache_render_text()
+int flvtag_addseinalu(flvtag_t* tag, const uint8_t* data, size_t size);
+////////////////////////////////////////////////////////////////////////////////
+// Gather write. The tag header, the SEI, the untouched payload and the footer are
+// written with a single writev(), so the tag is never modified or copied. Works on
+// views. sei may be NULL to pass the tag through
+int flv_writev_tag(FILE* flv, flvtag_t* tag, sei_t* sei);
+int flv_writev_caption_scc(FILE* flv, flvtag_t* tag, const scc_t* scc);
+int flv_writev_caption_text(FILE* flv, flvtag_t* tag, const utf8_char_t* text);
+int flv_writev_seinalu(FILE* flv, flvtag_t* tag, const uint8_t* data, size_t size);
 ////////////////////////////////////////////////////////////////////////////////
 int flvtag_amfcaption_708(flvtag_t* tag, uint32_t timestamp, sei_message_t* msg);
 ////////////////////////////////////////////////////////////////////////////////
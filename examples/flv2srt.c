@@ -31,6 +31,8 @@ int main(int argc, char** argv)
     const char* path = argv[1];
 
     sei_t sei;
+    flv_map_t map;
+    FILE* flv = NULL;
     flvtag_t tag;
     srt_t *srt = 0, *head = 0;
     int has_audio, has_video;
@@ -39,15 +41,18 @@ int main(int argc, char** argv)
     flvtag_init(&tag);
     caption_frame_init(&frame);
 
-    FILE* flv = flv_open_read(path);
+    // Tags are read as views into the mapping, nothing is copied. Stdin and pipes are read as a stream
+    if (!flv_map_open(&map, path)) {
+        flv = flv_open_read(path);
+    }
 
-    if (!flv_read_header(flv, &has_audio, &has_video)) {
+    if (!(flv ? flv_read_header(flv, &has_audio, &has_video) : flv_map_read_header(&map, &has_audio, &has_video))) {
         fprintf(stderr, "'%s' Not an flv file\n", path);
     } else {
         fprintf(stderr, "Reading from '%s'\n", path);
     }
 
-    while (flv_read_tag(flv, &tag)) {
+    while (flv ? flv_read_tag(flv, &tag) : flv_map_read_tag(&map, &tag)) {
         if (flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
             ssize_t size = flvtag_payload_size(&tag);
             uint8_t* data = flvtag_payload_data(&tag);
@@ -77,6 +82,12 @@ int main(int argc, char** argv)
 
     srt_dump(head);
     srt_free(head);
+    flvtag_free(&tag);
+    flv_map_close(&map);
+
+    if (flv) {
+        flv_close(flv);
+    }
 
     return 1;
 }
@@ -22,6 +22,7 @@
 /* THE SOFTWARE.                                                                              */
 /**********************************************************************************************/
 #include "avc.h"
+#include "encoder.h"
 #include "flv.h"
 #include "srt.h"
 #include "wonderland.h"
@@ -30,6 +31,7 @@
 #include <string.h>
 
 #define SECONDS_PER_LINE 3.0
+#define FRAME_RATE (30000.0 / 1001.0)
 srt_t* appennd_caption(const utf8_char_t* data, srt_t* prev, srt_t** head)
 {
 
@@ -60,13 +62,19 @@ srt_t* appennd_caption(const utf8_char_t* data, srt_t* prev, srt_t** head)
 
 int main(int argc, char** argv)
 {
-    int i = 0;
+    int i = 0, pending = 0;
+    sei_t sei;
     flvtag_t tag;
+    caption_encoder_t enc;
+    caption_scheduler_t sched;
     srt_t *head = 0, *tail = 0;
     int has_audio, has_video;
     FILE* flv = flv_open_read(argv[1]);
     FILE* out = flv_open_write(argv[2]);
+    double fps = 3 < argc ? atof(argv[3]) : FRAME_RATE;
     flvtag_init(&tag);
+    caption_scheduler_init(&sched, fps);
+    caption_encoder_init(&enc, caption_encoder_roll_up_3);
 
     for (i = 0; wonderland[i][0]; ++i) {
         tail = appennd_caption(wonderland[i], tail, &head);
@@ -80,10 +88,23 @@ int main(int argc, char** argv)
     flv_write_header(out, has_audio, has_video);
 
     while (flv_read_tag(flv, &tag)) {
-        if (head && flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag) && head->timestamp <= flvtag_pts_seconds(&tag)) {
-            fprintf(stderr, "%f %s\n", flvtag_pts_seconds(&tag), srt_data(head));
-            flvtag_addcaption_text(&tag, srt_data(head));
-            head = srt_free_head(head);
+        if (flvtag_avcpackettype_nalu == flvtag_avcpackettype(&tag)) {
+            if (head && head->timestamp <= flvtag_pts_seconds(&tag)) {
+                // the second write also carries anything the first could not queue
+                caption_encoder_push(&enc, &sched, "\n");
+                pending = (LIBCAPTION_OK != caption_encoder_push(&enc, &sched, srt_data(head)));
+                fprintf(stderr, "%f %s (displayed at %f)\n", flvtag_pts_seconds(&tag), srt_data(head),
+                    caption_scheduler_display_time(&sched, flvtag_pts_seconds(&tag)));
+                head = srt_free_head(head);
+            } else if (pending) {
+                pending = (LIBCAPTION_OK != caption_encoder_push(&enc, &sched, ""));
+            }
+
+            // every frame carries its share of the 608 line
+            sei_init(&sei);
+            sei_from_caption_scheduler(&sei, &sched);
+            flvtag_mergesei(&tag, &sei);
+            sei_free(&sei);
         }
 
         flv_write_tag(out, &tag);
@@ -30,17 +30,22 @@
 int main(int argc, char** argv)
 {
     int i;
-    scc_t* scc = NULL;
+    scc_t* scc;
+    scc_reader_t reader;
     size_t scc_size = 0;
     caption_frame_t frame;
     srt_t *srt = 0, *head = 0;
-    utf8_char_t* scc_data_ptr = utf8_load_text_file(argv[1], &scc_size);
-    utf8_char_t* scc_data = scc_data_ptr;
+    const utf8_char_t* scc_data = utf8_map_text_file(argv[1], &scc_size);
+
+    if (!scc_data || !scc_reader_init(&reader, scc_data, scc_size)) {
+        fprintf(stderr, "%s is not an scc file\n", argv[1]);
+        utf8_unmap_text_file(scc_data, scc_size);
+        return EXIT_FAILURE;
+    }
 
     caption_frame_init(&frame);
-    scc_data += scc_to_608(&scc, scc_data);
 
-    while (scc->cc_size) {
+    while ((scc = scc_reader_next(&reader))) {
         for (i = 0; i < scc->cc_size; ++i) {
             // eia608_dump (scc->cc_data[i]);
 
@@ -48,12 +53,11 @@ int main(int argc, char** argv)
                 srt = srt_from_caption_frame(&frame, srt, &head);
             }
         }
-
-        scc_data += scc_to_608(&scc, scc_data);
     }
 
     srt_dump(head);
     srt_free(head);
-    free(scc_data_ptr);
+    scc_reader_free(&reader);
+    utf8_unmap_text_file(scc_data, scc_size);
     return EXIT_SUCCESS;
 }
@@ -29,16 +29,21 @@
 int main(int argc, char** argv)
 {
     int i;
-    scc_t* scc = NULL;
+    scc_t* scc;
+    scc_reader_t reader;
     size_t scc_size = 0;
     caption_frame_t frame;
-    utf8_char_t* scc_data_ptr = utf8_load_text_file(argv[1], &scc_size);
-    utf8_char_t* scc_data = scc_data_ptr;
+    const utf8_char_t* scc_data = utf8_map_text_file(argv[1], &scc_size);
+
+    if (!scc_data || !scc_reader_init(&reader, scc_data, scc_size)) {
+        fprintf(stderr, "%s is not an scc file\n", argv[1]);
+        utf8_unmap_text_file(scc_data, scc_size);
+        return EXIT_FAILURE;
+    }
 
     caption_frame_init(&frame);
-    scc_data += scc_to_608(&scc, scc_data);
 
-    while (scc->cc_size) {
+    while ((scc = scc_reader_next(&reader))) {
         fprintf(stderr, "Timestamp: %f\n", scc->timestamp);
 
         for (i = 0; i < scc->cc_size; ++i) {
@@ -47,10 +52,13 @@ int main(int argc, char** argv)
                 caption_frame_dump(&frame);
             }
         }
+    }
 
-        scc_data += scc_to_608(&scc, scc_data);
+    if (reader.parity_errors) {
+        fprintf(stderr, "%u words failed the parity check\n", (unsigned)reader.parity_errors);
     }
 
-    free(scc_data_ptr);
+    scc_reader_free(&reader);
+    utf8_unmap_text_file(scc_data, scc_size);
     return EXIT_SUCCESS;
 }
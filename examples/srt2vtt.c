@@ -29,6 +29,93 @@
 #define MAX_SRT_SIZE (10 * 1024 * 1024)
 #define MAX_READ_SIZE 4096
 
+typedef struct {
+    FILE* playlist;
+    const char* prefix;
+} segments_t;
+
+int write_segment(void* opaque, unsigned sequence, double start, double duration, const utf8_char_t* data, size_t size)
+{
+    char path[FILENAME_MAX];
+    segments_t* segments = (segments_t*)opaque;
+    snprintf(path, sizeof(path), "%s%u.vtt", segments->prefix, sequence);
+    FILE* file = fopen(path, "wb");
+
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 0;
+    }
+
+    size_t written = fwrite(data, 1, size, file);
+    fclose(file);
+
+    // playlist entries are relative to the playlist
+    const char* name = strrchr(path, '/');
+    fprintf(segments->playlist, "#EXTINF:%0.3f,\n%s\n", duration, name ? name + 1 : path);
+    return written == size;
+}
+
+// Reads the SRT a piece at a time, each cue is written to its segments as soon as it is parsed
+int segment(FILE* file, double duration, const char* playlist_path, int64_t mpegts)
+{
+    size_t read;
+    char prefix[FILENAME_MAX];
+    utf8_char_t data[MAX_READ_SIZE];
+    srt_t *head = 0, *tail = 0, *prev;
+    srt_parser_t* parser = malloc(sizeof(srt_parser_t));
+    segments_t segments = { fopen(playlist_path, "w"), prefix };
+    vtt_segmenter_t seg;
+    int ok = 1;
+
+    if (!segments.playlist) {
+        free(parser);
+        return 0;
+    }
+
+    // segments are named after the playlist: out.m3u8 gets out0.vtt, out1.vtt...
+    snprintf(prefix, sizeof(prefix), "%s", playlist_path);
+    char* ext = strrchr(prefix, '.');
+
+    if (ext && !strchr(ext, '/')) {
+        (*ext) = '\0';
+    }
+
+    fprintf(segments.playlist, "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:%d\n#EXT-X-MEDIA-SEQUENCE:0\n#EXT-X-PLAYLIST-TYPE:VOD\n", (int)duration + ((int)duration < duration));
+    vtt_segmenter_init(&seg, duration, mpegts, write_segment, &segments);
+    srt_parser_init(parser);
+
+    for (;;) {
+        read = fread(data, 1, MAX_READ_SIZE, file);
+        prev = tail;
+        tail = read ? srt_parser_push(parser, data, read, tail, &head) : srt_parser_flush(parser, tail, &head);
+
+        // The last cue is only kept for the parser to link new cues to
+        if (prev && head) {
+            srt_free_head(prev);
+        }
+
+        for (; ok && head; head = head != tail ? srt_free_head(head) : 0) {
+            ok = vtt_segmenter_push(&seg, head);
+        }
+
+        if (!read || !ok) {
+            break;
+        }
+    }
+
+    if (ok && vtt_segmenter_finish(&seg, 0)) {
+        fprintf(segments.playlist, "#EXT-X-ENDLIST\n");
+    } else {
+        ok = 0;
+    }
+
+    srt_free(head ? head : tail);
+    vtt_segmenter_free(&seg);
+    fclose(segments.playlist);
+    free(parser);
+    return ok;
+}
+
 size_t read_file(FILE* file, utf8_char_t* data, size_t size)
 {
     size_t read, totl = 0;
@@ -42,21 +129,61 @@ size_t read_file(FILE* file, utf8_char_t* data, size_t size)
     return totl;
 }
 
+// Pipes and other streams can't be mapped, they are read into a buffer instead
+utf8_char_t* read_path(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "r");
+    utf8_char_t* data = file ? (utf8_char_t*)malloc(MAX_SRT_SIZE) : 0;
+
+    if (data) {
+        (*size) = read_file(file, data, MAX_SRT_SIZE);
+    }
+
+    if (file) {
+        fclose(file);
+    }
+
+    return data;
+}
+
 int main(int argc, char** argv)
 {
     if (argc < 2) {
+        fprintf(stderr, "Usage: %s file.srt [segment_seconds playlist.m3u8 [mpegts]]\n", argv[0]);
         return 0;
     }
 
-    FILE* file = fopen(argv[1], "r");
+    if (4 <= argc) {
+        FILE* file = fopen(argv[1], "r");
 
-    if (!file) {
-        return 0;
+        if (!file) {
+            fprintf(stderr, "Failed to open '%s'\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+
+        double duration = atof(argv[2]);
+        int64_t mpegts = 5 <= argc ? strtoll(argv[4], 0, 10) : 0;
+        int ok = 0 < duration && segment(file, duration, argv[3], mpegts);
+        fclose(file);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    size_t size = 0;
+    utf8_char_t* copy = 0;
+    const utf8_char_t* data = utf8_map_text_file(argv[1], &size);
+
+    if (!data && !(data = copy = read_path(argv[1], &size))) {
+        fprintf(stderr, "Failed to read '%s'\n", argv[1]);
+        return EXIT_FAILURE;
     }
 
-    utf8_char_t* data = malloc(MAX_SRT_SIZE);
-    size_t size = read_file(file, data, MAX_SRT_SIZE);
     srt_t* head = srt_parse(data, size);
     vtt_dump(head);
     srt_free(head);
+
+    if (copy) {
+        free(copy);
+    } else {
+        utf8_unmap_text_file(data, size);
+    }
 }
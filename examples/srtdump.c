@@ -44,6 +44,23 @@ size_t read_file(FILE* file, utf8_char_t* data, size_t size)
     return totl;
 }
 
+// Pipes and other streams can't be mapped, they are read into a buffer instead
+utf8_char_t* read_path(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "r");
+    utf8_char_t* data = file ? (utf8_char_t*)malloc(MAX_SRT_SIZE) : 0;
+
+    if (data) {
+        (*size) = read_file(file, data, MAX_SRT_SIZE);
+    }
+
+    if (file) {
+        fclose(file);
+    }
+
+    return data;
+}
+
 int main(int argc, char** argv)
 {
     srt_t* srt;
@@ -53,15 +70,20 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    FILE* file = fopen(argv[1], "r");
+    size_t size = 0;
+    utf8_char_t* copy = 0;
+    const utf8_char_t* data = utf8_map_text_file(argv[1], &size);
 
-    if (!file) {
-        return 0;
+    if (!data && !(data = copy = read_path(argv[1], &size))) {
+        fprintf(stderr, "Failed to read '%s'\n", argv[1]);
+        return EXIT_FAILURE;
     }
 
-    utf8_char_t* data = (utf8_char_t*)malloc(MAX_SRT_SIZE);
-    size_t size = read_file(file, data, MAX_SRT_SIZE);
-    srt_t* head = srt_parse(data, size);
+    srt_t* head = vtt_parse(data, size);
+
+    if (!head) {
+        head = srt_parse(data, size);
+    }
 
     for (srt = head; srt; srt = srt->next) {
         caption_frame_init(&frame);
@@ -70,4 +92,10 @@ int main(int argc, char** argv)
     }
 
     srt_free(head);
+
+    if (copy) {
+        free(copy);
+    } else {
+        utf8_unmap_text_file(data, size);
+    }
 }
@@ -0,0 +1,139 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#include "avc.h"
+#include "scc.h"
+#include "ts.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TS_READ_PACKETS 1024
+// H.264 holds at most 16 frames for reordering, allow for two SEI NALUs in each
+#define REORDER_DEPTH 32
+
+// SEIs arrive in decode order. With B-frames their pts go back and forth, so they are held
+// here sorted by pts and written once REORDER_DEPTH later ones have arrived
+typedef struct {
+    size_t size;
+    sei_t sei[REORDER_DEPTH];
+} reorder_t;
+
+// Writes and frees the SEI with the lowest pts
+static void reorder_pop(reorder_t* reorder, scc_writer_t* scc)
+{
+    sei_to_scc(&reorder->sei[0], scc);
+    sei_free(&reorder->sei[0]);
+    memmove(&reorder->sei[0], &reorder->sei[1], --reorder->size * sizeof(sei_t));
+}
+
+// Takes ownership of sei. Equal pts keep their decode order
+static void reorder_push(reorder_t* reorder, sei_t* sei, scc_writer_t* scc)
+{
+    size_t i;
+
+    if (REORDER_DEPTH == reorder->size) {
+        reorder_pop(reorder, scc);
+    }
+
+    for (i = reorder->size; 0 < i && sei_pts(sei) < sei_pts(&reorder->sei[i - 1]); --i) {
+        reorder->sei[i] = reorder->sei[i - 1];
+    }
+
+    reorder->sei[i] = (*sei);
+    ++reorder->size;
+}
+
+int main(int argc, char** argv)
+{
+    size_t i, count;
+    ts_t ts;
+    sei_t sei;
+    avcnalu_t nalu;
+    scc_writer_t scc;
+    reorder_t reorder;
+    utf8_writer_t* output;
+    uint8_t* pkt;
+
+    if (2 > argc) {
+        fprintf(stderr, "Usage: %s input.ts [--drop-frame] > output.scc\n"
+                        "Reads the first H.264 stream, 608 in its GA94 SEIs is written in presentation order.\n"
+                        "Only checked against streams remuxed from FLV, not broadcast captures\n",
+            argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+
+    if (!file) {
+        fprintf(stderr, "Falule to open input ts '%s'\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    ts_init(&ts);
+    reorder.size = 0;
+    avcnalu_init(&nalu);
+    pkt = (uint8_t*)malloc(TS_PACKET_SIZE * TS_READ_PACKETS);
+    output = (utf8_writer_t*)malloc(sizeof(utf8_writer_t));
+    utf8_writer_init_file(output, stdout);
+    scc_writer_init(&scc, output, 3 <= argc && 0 == strcmp("--drop-frame", argv[2]));
+
+    while (0 < (count = fread(pkt, TS_PACKET_SIZE, TS_READ_PACKETS, file))) {
+        for (i = 0; i < count; ++i) {
+            if (LIBCAPTION_READY != ts_parse_packet(&ts, &pkt[i * TS_PACKET_SIZE])) {
+                continue;
+            }
+
+            while (ts.size) {
+                switch (avcnalu_parse_annexb(&nalu, &ts.data, &ts.size)) {
+                case LIBCAPTION_OK:
+                    break;
+
+                case LIBCAPTION_ERROR:
+                    avcnalu_init(&nalu);
+                    break;
+
+                case LIBCAPTION_READY:
+                    if (6 == avcnalu_type(&nalu)) {
+                        sei_init(&sei);
+                        sei_parse_avcnalu(&sei, &nalu, ts_dts_seconds(&ts), ts_cts_seconds(&ts));
+                        reorder_push(&reorder, &sei, &scc);
+                    }
+
+                    avcnalu_init(&nalu);
+                    break;
+                }
+            }
+        }
+    }
+
+    while (reorder.size) {
+        reorder_pop(&reorder, &scc);
+    }
+
+    scc_writer_flush(&scc);
+    free(output);
+    free(pkt);
+    fclose(file);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+// Compares the table based utf8 to 608 lookup with the re2c generated one
+//   utf8bench              time both over the text of wonderland.h
+//   utf8bench --verify     check that both agree on every 1, 2 and 3 byte sequence
+//   utf8bench --generate   print the lookup tables used by eia608.c
+#include "eia608.h"
+#include "wonderland.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ROUNDS 200
+
+// defined in eia608.c and eia608_from_utf8.c
+uint16_t _eia608_from_utf8(const utf8_char_t* s);
+uint16_t _eia608_from_utf8_table(const utf8_char_t* s);
+
+static void generate()
+{
+    int i, m, c1, c2;
+    utf8_char_t s[4] = { 0, 0, 0, 0 };
+    uint16_t key[64], val[64];
+    int count = 0;
+
+    printf("static const uint16_t eia608_from_ascii[128] = {");
+
+    for (i = 0; i < 128; ++i) {
+        s[0] = (utf8_char_t)i;
+        printf("%s0x%04X,", 0 == i % 8 ? "\n    " : " ", _eia608_from_utf8(s));
+    }
+
+    printf("\n};\n\n// indexed by (lead - 0xC2) * 64 + (continuation & 0x3F)\n");
+    printf("static const uint16_t eia608_from_utf8_2byte[128] = {");
+
+    for (i = 0; i < 128; ++i) {
+        s[0] = (utf8_char_t)(0xC2 + i / 64);
+        s[1] = (utf8_char_t)(0x80 + i % 64);
+        printf("%s0x%04X,", 0 == i % 8 ? "\n    " : " ", _eia608_from_utf8(s));
+    }
+
+    // everything else that maps is a three byte sequence with a 0xE2 lead
+    for (c1 = 0x80; c1 < 0xC0; ++c1) {
+        for (c2 = 0x80; c2 < 0xC0; ++c2) {
+            s[0] = (utf8_char_t)0xE2;
+            s[1] = (utf8_char_t)c1;
+            s[2] = (utf8_char_t)c2;
+
+            if (_eia608_from_utf8(s)) {
+                key[count] = (uint16_t)(0x2000 | ((c1 & 0x3F) << 6) | (c2 & 0x3F));
+                val[count] = _eia608_from_utf8(s);
+                ++count;
+            }
+        }
+    }
+
+    // smallest modulus that gives every code point its own slot
+    for (m = count;; ++m) {
+        int used[64] = { 0 };
+
+        for (i = 0; i < count && !used[key[i] % m]; ++i) {
+            used[key[i] % m] = 1;
+        }
+
+        if (i == count) {
+            break;
+        }
+    }
+
+    printf("\n};\n\n// three byte sequences, perfect hash on code point %% %d\n", m);
+    printf("#define EIA608_FROM_UTF8_3BYTE_MOD %d\n", m);
+    printf("static const uint16_t eia608_from_utf8_3byte[%d][2] = {\n", m);
+
+    for (i = 0; i < m; ++i) {
+        int j;
+
+        for (j = 0; j < count && key[j] % m != i; ++j) {
+        }
+
+        printf("    { 0x%04X, 0x%04X },\n", j < count ? key[j] : 0, j < count ? val[j] : 0);
+    }
+
+    printf("};\n");
+}
+
+static int verify()
+{
+    int c0, c1, c2, fails = 0;
+    utf8_char_t s[4] = { 0, 0, 0, 0 };
+
+    for (c0 = 0; c0 < 256; ++c0) {
+        for (c1 = 0; c1 < 256; ++c1) {
+            for (c2 = 0; c2 < 256; ++c2) {
+                s[0] = (utf8_char_t)c0;
+                s[1] = (utf8_char_t)c1;
+                s[2] = (utf8_char_t)c2;
+
+                if (_eia608_from_utf8(s) != _eia608_from_utf8_table(s)) {
+                    fprintf(stderr, "%02X %02X %02X: 0x%04X != 0x%04X\n", c0, c1, c2, _eia608_from_utf8(s), _eia608_from_utf8_table(s));
+                    ++fails;
+                }
+            }
+        }
+    }
+
+    printf("%d mismatches\n", fails);
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static double bench(uint16_t (*from_utf8)(const utf8_char_t*), size_t* chars, unsigned int* sum)
+{
+    int i, r;
+    const utf8_char_t* c;
+    clock_t start = clock();
+    (*chars) = 0;
+
+    for (r = 0; r < ROUNDS; ++r) {
+        for (i = 0; wonderland[i][0]; ++i) {
+            for (c = wonderland[i]; *c; c = utf8_char_next(c)) {
+                (*sum) += from_utf8(c);
+                ++(*chars);
+            }
+        }
+    }
+
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv)
+{
+    size_t chars;
+    unsigned int sum1 = 0, sum2 = 0;
+
+    if (1 < argc && 0 == strcmp("--generate", argv[1])) {
+        generate();
+        return EXIT_SUCCESS;
+    }
+
+    if (1 < argc && 0 == strcmp("--verify", argv[1])) {
+        return verify();
+    }
+
+    double re2c = bench(_eia608_from_utf8, &chars, &sum1);
+    double table = bench(_eia608_from_utf8_table, &chars, &sum2);
+    printf("%zu chars, re2c %.2f ns/char, table %.2f ns/char%s\n", chars,
+        re2c * 1e9 / chars, table * 1e9 / chars, sum1 == sum2 ? "" : " (results differ!)");
+    return sum1 == sum2 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -401,11 +401,16 @@ int sei_parse_nalu(sei_t* sei, const uint8_t* data, size_t size, double dts, dou
     // There should be one trailing byte, 0x80. But really, we can just ignore that fact.
     return ret;
 error:
-    sei_init(sei);
+    sei_free(sei); // messages parsed before the error
     return 0;
 }
 ////////////////////////////////////////////////////////////////////////////////
 libcaption_stauts_t sei_to_caption_frame(sei_t* sei, caption_frame_t* frame)
+{
+    return sei_demux(sei, frame, 0);
+}
+
+libcaption_stauts_t sei_demux(sei_t* sei, caption_frame_t* frame, dtvcc_t* dtvcc)
 {
     cea708_t cea708;
     sei_message_t* msg;
@@ -416,17 +421,32 @@ libcaption_stauts_t sei_to_caption_frame(sei_t* sei, caption_frame_t* frame)
     for (msg = sei_message_head(sei); msg; msg = sei_message_next(msg)) {
         if (sei_type_user_data_registered_itu_t_t35 == sei_message_type(msg)) {
             cea708_parse(sei_message_data(msg), sei_message_size(msg), &cea708);
-            status = libcaption_status_update(status, cea708_to_caption_frame(frame, &cea708, sei_pts(sei)));
+            status = libcaption_status_update(status, cea708_demux(&cea708, frame, dtvcc, sei_pts(sei)));
         }
     }
 
-    if (LIBCAPTION_READY == status) {
+    if (frame && LIBCAPTION_READY == status) {
         frame->timestamp = sei_pts(sei);
     }
 
     return status;
 }
 
+size_t sei_to_cea708_batch(sei_t* sei, cea708_batch_t* batch)
+{
+    size_t count = 0;
+    sei_message_t* msg;
+
+    for (msg = sei_message_head(sei); msg && batch->size < batch->capacity; msg = sei_message_next(msg)) {
+        if (sei_type_user_data_registered_itu_t_t35 == sei_message_type(msg)
+            && LIBCAPTION_ERROR != cea708_batch_parse(batch, sei_message_data(msg), sei_message_size(msg))) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 #define DEFAULT_CHANNEL 0
 
@@ -463,80 +483,20 @@ void sei_encode_eia608(sei_t* sei, cea708_t* cea708, uint16_t cc_data)
     cea708_add_cc_data(cea708, 1, cc_type_ntsc_cc_field_1, cc_data);
 }
 ////////////////////////////////////////////////////////////////////////////////
-// TODO move this out of sei
 libcaption_stauts_t sei_from_caption_frame(sei_t* sei, caption_frame_t* frame)
 {
-    int r, c;
+    size_t i, count;
     cea708_t cea708;
-    const char* data;
-    uint16_t prev_cc_data;
+    uint16_t cc_data[CAPTION_FRAME_CC_DATA_SIZE];
 
+    // ENM, RCL, ..., EOC
+    count = caption_frame_to_608(frame, &cc_data[0], CAPTION_FRAME_CC_DATA_SIZE);
     cea708_init(&cea708); // set up a new popon frame
-    cea708_add_cc_data(&cea708, 1, cc_type_ntsc_cc_field_1, eia608_control_command(eia608_control_erase_non_displayed_memory, DEFAULT_CHANNEL));
-    cea708_add_cc_data(&cea708, 1, cc_type_ntsc_cc_field_1, eia608_control_command(eia608_control_resume_caption_loading, DEFAULT_CHANNEL));
-
-    for (r = 0; r < SCREEN_ROWS; ++r) {
-        // Calculate preamble
-        for (c = 0; c < SCREEN_COLS && 0 == *caption_frame_read_char(frame, r, c, 0, 0); ++c) {
-        }
-
-        // This row is blank
-        if (SCREEN_COLS == c) {
-            continue;
-        }
-
-        // Write preamble
-        sei_encode_eia608(sei, &cea708, eia608_row_column_pramble(r, c, DEFAULT_CHANNEL, 0));
-        int tab = c % 4;
+    cea708_add_cc_data(&cea708, 1, cc_type_ntsc_cc_field_1, cc_data[0]);
+    cea708_add_cc_data(&cea708, 1, cc_type_ntsc_cc_field_1, cc_data[1]);
 
-        if (tab) {
-            sei_encode_eia608(sei, &cea708, eia608_tab(tab, DEFAULT_CHANNEL));
-        }
-
-        // Write the row
-        for (prev_cc_data = 0, data = caption_frame_read_char(frame, r, c, 0, 0);
-             (*data) && c < SCREEN_COLS; ++c, data = caption_frame_read_char(frame, r, c, 0, 0)) {
-            uint16_t cc_data = eia608_from_utf8_1(data, DEFAULT_CHANNEL);
-
-            if (!cc_data) {
-                // We do't want to write bad data, so just ignore it.
-            } else if (eia608_is_basicna(prev_cc_data)) {
-                if (eia608_is_basicna(cc_data)) {
-                    // previous and current chars are both basicna, combine them into current
-                    sei_encode_eia608(sei, &cea708, eia608_from_basicna(prev_cc_data, cc_data));
-                } else if (eia608_is_westeu(cc_data)) {
-                    // extended charcters overwrite the previous charcter, so insert a dummy char thren write the extended char
-                    sei_encode_eia608(sei, &cea708, eia608_from_basicna(prev_cc_data, eia608_from_utf8_1(EIA608_CHAR_SPACE, DEFAULT_CHANNEL)));
-                    sei_encode_eia608(sei, &cea708, cc_data);
-                } else {
-                    // previous was basic na, but current isnt; write previous and current
-                    sei_encode_eia608(sei, &cea708, prev_cc_data);
-                    sei_encode_eia608(sei, &cea708, cc_data);
-                }
-
-                prev_cc_data = 0; // previous is handled, we can forget it now
-            } else if (eia608_is_westeu(cc_data)) {
-                // extended chars overwrite the previous chars, so insert a dummy char
-                // TODO create a map of alternamt chars for eia608_is_westeu instead of using space
-                sei_encode_eia608(sei, &cea708, eia608_from_utf8_1(EIA608_CHAR_SPACE, DEFAULT_CHANNEL));
-                sei_encode_eia608(sei, &cea708, cc_data);
-            } else if (eia608_is_basicna(cc_data)) {
-                prev_cc_data = cc_data;
-            } else {
-                sei_encode_eia608(sei, &cea708, cc_data);
-            }
-
-            if (eia608_is_specialna(cc_data)) {
-                // specialna are treated as control charcters. Duplicated control charcters are discarded
-                // So we write a resume after a specialna as a noop to break repetition detection
-                // TODO only do this if the same charcter is repeated
-                sei_encode_eia608(sei, &cea708, eia608_control_command(eia608_control_resume_caption_loading, DEFAULT_CHANNEL));
-            }
-        }
-
-        if (0 != prev_cc_data) {
-            sei_encode_eia608(sei, &cea708, prev_cc_data);
-        }
+    for (i = 2; i < count - 1; ++i) {
+        sei_encode_eia608(sei, &cea708, cc_data[i]);
     }
 
     sei_encode_eia608(sei, &cea708, 0); // flush
@@ -566,6 +526,46 @@ libcaption_stauts_t sei_from_scc(sei_t* sei, const scc_t* scc)
     return LIBCAPTION_OK;
 }
 
+libcaption_stauts_t sei_to_scc(sei_t* sei, scc_writer_t* writer)
+{
+    int i, end, size, count, valid;
+    uint16_t cc_data[32];
+    cea708_t cea708;
+    cea708_cc_type_t type;
+    sei_message_t* msg;
+
+    for (msg = sei_message_head(sei); msg; msg = sei_message_next(msg)) {
+        if (sei_type_user_data_registered_itu_t_t35 != sei_message_type(msg)) {
+            continue;
+        }
+
+        cea708_init(&cea708);
+
+        if (LIBCAPTION_OK != cea708_parse(sei_message_data(msg), sei_message_size(msg), &cea708) || GA94 != cea708.user_identifier) {
+            continue;
+        }
+
+        count = cea708_cc_count(&cea708.user_data);
+
+        for (i = 0, size = 0; i < count; ++i) {
+            uint16_t word = cea708_cc_data(&cea708.user_data, i, &valid, &type);
+
+            if (valid && cc_type_ntsc_cc_field_1 == type) {
+                cc_data[size++] = word;
+            }
+        }
+
+        // A word damaged in transport would be written out as good data, decoders drop it so leave it out
+        for (i = 0; i < size; ++i) {
+            for (end = i + (int)eia608_parity_varify_words(&cc_data[i], size - i); i < end; ++i) {
+                scc_writer_write(writer, sei_pts(sei), cc_data[i]);
+            }
+        }
+    }
+
+    return LIBCAPTION_OK;
+}
+
 libcaption_stauts_t sei_from_caption_clear(sei_t* sei)
 {
     cea708_t cea708;
@@ -579,6 +579,242 @@ libcaption_stauts_t sei_from_caption_clear(sei_t* sei)
     sei_append_708(sei, &cea708);
     return LIBCAPTION_OK;
 }
+
+libcaption_stauts_t sei_from_caption_scheduler(sei_t* sei, caption_scheduler_t* sched)
+{
+    cea708_t cea708;
+    caption_scheduler_next(sched, &cea708);
+    sei_append_708(sei, &cea708);
+    return LIBCAPTION_OK;
+}
+
+libcaption_stauts_t sei_merge_cea708(sei_t* sei, sei_t* from)
+{
+    cea708_t cea708, merge;
+    uint8_t data[CEA608_MAX_SIZE];
+    sei_message_t *msg, *from_msg, *prev = 0;
+
+    for (msg = sei_message_head(sei); msg; prev = msg, msg = sei_message_next(msg)) {
+        if (LIBCAPTION_OK == sei_decode_cea708(msg, &cea708) && GA94 == cea708.user_identifier && 3 == cea708.user_data_type_code) {
+            break;
+        }
+    }
+
+    if (!msg) {
+        return LIBCAPTION_ERROR;
+    }
+
+    // merge everything into the copy first, so a failure leaves sei as it was
+    for (from_msg = sei_message_head(from); from_msg; from_msg = sei_message_next(from_msg)) {
+        if (sei_type_user_data_registered_itu_t_t35 != sei_message_type(from_msg)) {
+            continue;
+        }
+
+        if (LIBCAPTION_OK != sei_decode_cea708(from_msg, &merge) || LIBCAPTION_OK != cea708_merge_cc_data(&cea708, &merge)) {
+            return LIBCAPTION_ERROR;
+        }
+    }
+
+    size_t size = cea708_render(&cea708, &data[0], sizeof(data));
+
+    if (size == sei_message_size(msg)) {
+        memcpy(sei_message_data(msg), &data[0], size);
+        return LIBCAPTION_OK;
+    }
+
+    // The original carried bytes cea708_parse() does not keep, swap in a new message
+    sei_message_t* next = sei_message_new(sei_message_type(msg), &data[0], size);
+    next->next = msg->next;
+
+    if (prev) {
+        prev->next = next;
+    } else {
+        sei->head = next;
+    }
+
+    if (sei->tail == msg) {
+        sei->tail = next;
+    }
+
+    sei_message_free(msg);
+    return LIBCAPTION_OK;
+}
+////////////////////////////////////////////////////////////////////////////////
+#define SEI_CACHE_TEXT 0
+#define SEI_CACHE_SCC 1
+#define SEI_CACHE_CLEAR 2
+
+struct _sei_cache_entry_t {
+    uint64_t hash;
+    int kind;
+    size_t key_size;
+    size_t nalu_size;
+    struct _sei_cache_entry_t* prev;
+    struct _sei_cache_entry_t* next;
+    struct _sei_cache_entry_t* chain;
+    // key data follows, then nalu data
+};
+
+static inline uint8_t* sei_cache_entry_key(sei_cache_entry_t* entry) { return ((uint8_t*)entry) + sizeof(struct _sei_cache_entry_t); }
+static inline uint8_t* sei_cache_entry_nalu(sei_cache_entry_t* entry) { return sei_cache_entry_key(entry) + entry->key_size; }
+
+// FNV-1a
+static uint64_t sei_cache_hash(int kind, const uint8_t* key, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL ^ (uint64_t)kind;
+
+    for (; 0 < size; ++key, --size) {
+        hash = (hash ^ (*key)) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+void sei_cache_init(sei_cache_t* cache, size_t capacity)
+{
+    size_t buckets = 16;
+
+    while (buckets < 2 * capacity) {
+        buckets *= 2;
+    }
+
+    memset(cache, 0, sizeof(sei_cache_t));
+    cache->capacity = capacity ? capacity : 1;
+    cache->bucket = (sei_cache_entry_t**)calloc(buckets, sizeof(sei_cache_entry_t*));
+    cache->bucket_mask = buckets - 1;
+}
+
+void sei_cache_free(sei_cache_t* cache)
+{
+    while (cache->head) {
+        sei_cache_entry_t* next = cache->head->next;
+        free(cache->head);
+        cache->head = next;
+    }
+
+    free(cache->bucket);
+    memset(cache, 0, sizeof(sei_cache_t));
+}
+
+static void sei_cache_unlink(sei_cache_t* cache, sei_cache_entry_t* entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+static void sei_cache_push_front(sei_cache_t* cache, sei_cache_entry_t* entry)
+{
+    entry->prev = 0;
+    entry->next = cache->head;
+
+    if (cache->head) {
+        cache->head->prev = entry;
+    } else {
+        cache->tail = entry;
+    }
+
+    cache->head = entry;
+}
+
+static void sei_cache_evict(sei_cache_t* cache)
+{
+    sei_cache_entry_t* entry = cache->tail;
+    sei_cache_entry_t** link = &cache->bucket[entry->hash & cache->bucket_mask];
+
+    while ((*link) != entry) {
+        link = &(*link)->chain;
+    }
+
+    (*link) = entry->chain;
+    sei_cache_unlink(cache, entry);
+    free(entry);
+    --cache->size;
+}
+
+static sei_cache_entry_t* sei_cache_find(sei_cache_t* cache, uint64_t hash, int kind, const uint8_t* key, size_t key_size)
+{
+    sei_cache_entry_t* entry;
+
+    for (entry = cache->bucket[hash & cache->bucket_mask]; entry; entry = entry->chain) {
+        if (hash == entry->hash && kind == entry->kind && key_size == entry->key_size && 0 == memcmp(key, sei_cache_entry_key(entry), key_size)) {
+            return entry;
+        }
+    }
+
+    return 0;
+}
+
+static const uint8_t* sei_cache_render(sei_cache_t* cache, int kind, const uint8_t* key, size_t key_size, const void* caption, size_t* size)
+{
+    uint64_t hash = sei_cache_hash(kind, key, key_size);
+    sei_cache_entry_t* entry = sei_cache_find(cache, hash, kind, key, key_size);
+
+    if (entry) {
+        ++cache->hits;
+        sei_cache_unlink(cache, entry);
+        sei_cache_push_front(cache, entry);
+        (*size) = entry->nalu_size;
+        return sei_cache_entry_nalu(entry);
+    }
+
+    sei_t sei;
+    sei_init(&sei);
+    ++cache->misses;
+
+    if (SEI_CACHE_SCC == kind) {
+        sei_from_scc(&sei, (const scc_t*)caption);
+    } else if (SEI_CACHE_TEXT == kind) {
+        caption_frame_t frame;
+        caption_frame_init(&frame);
+        caption_frame_from_text(&frame, (const utf8_char_t*)caption);
+        sei_from_caption_frame(&sei, &frame);
+    } else {
+        sei_from_caption_clear(&sei);
+    }
+
+    entry = (sei_cache_entry_t*)malloc(sizeof(struct _sei_cache_entry_t) + key_size + sei_render_size(&sei));
+    entry->hash = hash;
+    entry->kind = kind;
+    entry->key_size = key_size;
+    memcpy(sei_cache_entry_key(entry), key, key_size);
+    entry->nalu_size = sei_render(&sei, sei_cache_entry_nalu(entry));
+    sei_free(&sei);
+
+    if (cache->size >= cache->capacity) {
+        sei_cache_evict(cache);
+    }
+
+    entry->chain = cache->bucket[hash & cache->bucket_mask];
+    cache->bucket[hash & cache->bucket_mask] = entry;
+    sei_cache_push_front(cache, entry);
+    ++cache->size;
+
+    (*size) = entry->nalu_size;
+    return sei_cache_entry_nalu(entry);
+}
+
+const uint8_t* sei_cache_render_text(sei_cache_t* cache, const utf8_char_t* text, size_t* size)
+{
+    if (!text) {
+        return sei_cache_render(cache, SEI_CACHE_CLEAR, (const uint8_t*)"", 0, 0, size);
+    }
+
+    return sei_cache_render(cache, SEI_CACHE_TEXT, (const uint8_t*)text, strlen(text), text, size);
+}
+
+const uint8_t* sei_cache_render_scc(sei_cache_t* cache, const scc_t* scc, size_t* size)
+{
+    return sei_cache_render(cache, SEI_CACHE_SCC, (const uint8_t*)&scc->cc_data[0], scc->cc_size * sizeof(uint16_t), scc, size);
+}
 ////////////////////////////////////////////////////////////////////////////////
 static int avc_is_start_code(const uint8_t* data, int size, int* len)
 {
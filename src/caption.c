@@ -72,23 +72,24 @@ static caption_frame_buffer_t* frame_write_buffer(caption_frame_t* frame)
         return 0;
     }
 }
-
-static caption_frame_cell_t* frame_cell(caption_frame_t* frame, int row, int col)
-{
-    return frame_buffer_cell(frame_write_buffer(frame), row, col);
-}
 ////////////////////////////////////////////////////////////////////////////////
-uint16_t _eia608_from_utf8(const char* s); // function is in eia608.c.re2c
-int caption_frame_write_char(caption_frame_t* frame, int row, int col, eia608_style_t style, int underline, const char* c)
+// Writes c without checking it is encodable. Decoded text comes straight from
+// eia608_char_map, so there is no need to map it back to 608 just to validate it.
+static int frame_write_cell(caption_frame_t* frame, int row, int col, eia608_style_t style, int underline, const char* c)
 {
     caption_frame_buffer_t* buff = frame_write_buffer(frame);
 
-    if (!buff || !_eia608_from_utf8(c)) {
+    if (!buff) {
         return 0;
     }
 
     caption_frame_cell_t* cell = frame_buffer_cell(buff, row, col);
 
+    if (cell && !c[0]) {
+        memset(cell, 0, sizeof(caption_frame_cell_t));
+        return 1;
+    }
+
     if (cell && utf8_char_copy(&cell->data[0], c)) {
         cell->uln = underline;
         cell->sty = style;
@@ -98,9 +99,21 @@ int caption_frame_write_char(caption_frame_t* frame, int row, int col, eia608_st
     return 0;
 }
 
+uint16_t _eia608_from_utf8_table(const char* s); // function is in eia608.c
+int caption_frame_write_char(caption_frame_t* frame, int row, int col, eia608_style_t style, int underline, const char* c)
+{
+    // EIA608_CHAR_NULL clears the cell
+    if (c[0] && !_eia608_from_utf8_table(c)) {
+        return 0;
+    }
+
+    return frame_write_cell(frame, row, col, style, underline, c);
+}
+
 const utf8_char_t* caption_frame_read_char(caption_frame_t* frame, int row, int col, eia608_style_t* style, int* underline)
 {
-    caption_frame_cell_t* cell = frame_cell(frame, row, col);
+    // always read from displayed memory
+    caption_frame_cell_t* cell = frame_buffer_cell(&frame->front, row, col);
 
     if (!cell) {
         if (style) {
@@ -152,11 +165,11 @@ libcaption_stauts_t caption_frame_carriage_return(caption_frame_t* frame)
     return LIBCAPTION_OK;
 }
 ////////////////////////////////////////////////////////////////////////////////
-libcaption_stauts_t eia608_write_char(caption_frame_t* frame, char* c)
+libcaption_stauts_t eia608_write_char(caption_frame_t* frame, const char* c)
 {
     if (0 == c || 0 == c[0] || SCREEN_ROWS <= frame->state.row || 0 > frame->state.row || SCREEN_COLS <= frame->state.col || 0 > frame->state.col) {
         // NO-OP
-    } else if (caption_frame_write_char(frame, frame->state.row, frame->state.col, frame->state.sty, frame->state.uln, c)) {
+    } else if (frame_write_cell(frame, frame->state.row, frame->state.col, frame->state.sty, frame->state.uln, c)) {
         frame->state.col += 1;
     }
 
@@ -288,8 +301,8 @@ libcaption_stauts_t caption_frame_decode_control(caption_frame_t* frame, uint16_
 libcaption_stauts_t caption_frame_decode_text(caption_frame_t* frame, uint16_t cc_data)
 {
     int chan;
-    char char1[5], char2[5];
-    size_t chars = eia608_to_utf8(cc_data, &chan, &char1[0], &char2[0]);
+    const utf8_char_t *char1, *char2;
+    int chars = eia608_to_char(cc_data, &chan, &char1, &char2);
 
     if (eia608_is_westeu(cc_data)) {
         // Extended charcters replace the previous charcter for back compatibility
@@ -396,6 +409,315 @@ int caption_frame_from_text(caption_frame_t* frame, const utf8_char_t* data)
     return 0;
 }
 ////////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_CHANNEL 0
+
+typedef struct {
+    uint16_t* cc_data;
+    size_t size;
+    size_t count;
+    uint16_t noop; // harmless command, used to break up repeated commands
+    caption_frame_t* frame; // if set, tracks what a decoder displays after cc_data
+} frame_encoder_t;
+
+static void frame_encoder_push(frame_encoder_t* enc, uint16_t cc_data)
+{
+    if (enc->frame) {
+        // the tracked decoder needs parity now, otherwise it is applied in bulk once the encoder is done
+        cc_data = eia608_parity_word(cc_data);
+    }
+
+    // decoders discard a repeated command, so put something else between them
+    if (enc->frame && (eia608_is_specialna(cc_data) || eia608_is_control(cc_data)) && cc_data == enc->frame->state.cc_data) {
+        if (cc_data == enc->noop) {
+            return;
+        }
+
+        frame_encoder_push(enc, enc->noop);
+    }
+
+    if (enc->count < enc->size) {
+        enc->cc_data[enc->count++] = cc_data;
+
+        if (enc->frame) {
+            caption_frame_decode(enc->frame, cc_data, 0.0);
+        }
+    }
+}
+
+static inline uint16_t frame_encoder_basicna(uint16_t bna1, uint16_t bna2) { return (0xFF00 & bna1) | ((0xFF00 & bna2) >> 8); }
+
+// Writes the text of row r from column c, up to end or the first empty cell. Returns the column it stopped at
+// Text is pushed without parity, see frame_encoder_push
+static int frame_encoder_text(frame_encoder_t* enc, caption_frame_buffer_t* buff, int r, int c, int end)
+{
+    uint16_t prev_cc_data = 0;
+    caption_frame_cell_t* cell;
+    uint16_t space = _eia608_from_utf8_table(EIA608_CHAR_SPACE);
+
+    for (; c < end && (cell = frame_buffer_cell(buff, r, c)) && cell->data[0]; ++c) {
+        uint16_t cc_data = _eia608_from_utf8_table(&cell->data[0]); // DEFAULT_CHANNEL, so no channel bit
+
+        if (!cc_data) {
+            // We do't want to write bad data, so just ignore it.
+        } else if (eia608_is_basicna(prev_cc_data)) {
+            if (eia608_is_basicna(cc_data)) {
+                // previous and current chars are both basicna, combine them into current
+                frame_encoder_push(enc, frame_encoder_basicna(prev_cc_data, cc_data));
+            } else if (eia608_is_westeu(cc_data)) {
+                // extended charcters overwrite the previous charcter, so insert a dummy char thren write the extended char
+                frame_encoder_push(enc, frame_encoder_basicna(prev_cc_data, space));
+                frame_encoder_push(enc, cc_data);
+            } else {
+                // previous was basic na, but current isnt; write previous and current
+                frame_encoder_push(enc, prev_cc_data);
+                frame_encoder_push(enc, cc_data);
+            }
+
+            prev_cc_data = 0; // previous is handled, we can forget it now
+        } else if (eia608_is_westeu(cc_data)) {
+            // extended chars overwrite the previous chars, so insert a dummy char
+            // TODO create a map of alternamt chars for eia608_is_westeu instead of using space
+            frame_encoder_push(enc, space);
+            frame_encoder_push(enc, cc_data);
+        } else if (eia608_is_basicna(cc_data)) {
+            prev_cc_data = cc_data;
+        } else {
+            frame_encoder_push(enc, cc_data);
+        }
+
+        if (eia608_is_specialna(cc_data) && !enc->frame) {
+            // specialna are treated as control charcters. Duplicated control charcters are discarded
+            // So we write a resume after a specialna as a noop to break repetition detection
+            // TODO only do this if the same charcter is repeated
+            frame_encoder_push(enc, enc->noop);
+        }
+    }
+
+    if (0 != prev_cc_data) {
+        frame_encoder_push(enc, prev_cc_data);
+    }
+
+    return c;
+}
+
+size_t caption_frame_to_608(caption_frame_t* frame, uint16_t* cc_data, size_t size)
+{
+    int r, c;
+    frame_encoder_t enc = { cc_data, size, 0, eia608_control_command(eia608_control_resume_caption_loading, DEFAULT_CHANNEL), 0 };
+    frame_encoder_push(&enc, eia608_control_command(eia608_control_erase_non_displayed_memory, DEFAULT_CHANNEL));
+    frame_encoder_push(&enc, eia608_control_command(eia608_control_resume_caption_loading, DEFAULT_CHANNEL));
+
+    for (r = 0; r < SCREEN_ROWS; ++r) {
+        // Calculate preamble
+        for (c = 0; c < SCREEN_COLS && 0 == *caption_frame_read_char(frame, r, c, 0, 0); ++c) {
+        }
+
+        // This row is blank
+        if (SCREEN_COLS == c) {
+            continue;
+        }
+
+        // Write preamble
+        frame_encoder_push(&enc, eia608_row_column_pramble(r, c, DEFAULT_CHANNEL, 0));
+        int tab = c % 4;
+
+        if (tab) {
+            frame_encoder_push(&enc, eia608_tab(tab, DEFAULT_CHANNEL));
+        }
+
+        // Write the row
+        frame_encoder_text(&enc, &frame->front, r, c, SCREEN_COLS);
+    }
+
+    frame_encoder_push(&enc, eia608_control_command(eia608_control_end_of_caption, DEFAULT_CHANNEL));
+    eia608_parity_words(cc_data, enc.count);
+    return enc.count;
+}
+////////////////////////////////////////////////////////////////////////////////
+static inline int frame_cell_empty(caption_frame_cell_t* cell) { return 0 == cell->data[0]; }
+static inline int frame_cell_equal(caption_frame_cell_t* a, caption_frame_cell_t* b) { return 0 == strcmp(&a->data[0], &b->data[0]); }
+
+static void frame_encoder_move(frame_encoder_t* enc, int row, int col)
+{
+    caption_frame_state_t* state = &enc->frame->state;
+
+    if (row == state->row && state->col <= col && col - state->col <= 3) {
+        if (state->col < col) {
+            frame_encoder_push(enc, eia608_tab(col - state->col, DEFAULT_CHANNEL));
+        }
+
+        return;
+    }
+
+    frame_encoder_push(enc, eia608_row_column_pramble(row, col, DEFAULT_CHANNEL, 0));
+
+    if (col % 4) {
+        frame_encoder_push(enc, eia608_tab(col % 4, DEFAULT_CHANNEL));
+    }
+}
+
+// Makes row r of what is shown match row s of next
+static void frame_encoder_delta_row(frame_encoder_t* enc, caption_frame_buffer_t* next, int r, int s)
+{
+    int c = 0, end, last, same;
+    caption_frame_buffer_t* shown = &enc->frame->front;
+
+    // once cc_data is full nothing changes, so stop rather than retry the same cell
+    while (enc->count < enc->size) {
+        for (; c < SCREEN_COLS && frame_cell_equal(&shown->cell[r][c], &next->cell[s][c]); ++c) {
+        }
+
+        if (SCREEN_COLS == c) {
+            return;
+        }
+
+        if (frame_cell_empty(&next->cell[s][c])) {
+            for (end = c + 1; end < SCREEN_COLS && frame_cell_equal(&shown->cell[r][end], &next->cell[s][end]); ++end) {
+            }
+
+            if (r == enc->frame->state.row && c + 1 == enc->frame->state.col && SCREEN_COLS == end) {
+                // only the charcter before the cursor needs to go
+                frame_encoder_push(enc, eia608_control_command(eia608_control_backspace, DEFAULT_CHANNEL));
+            } else {
+                frame_encoder_move(enc, r, c);
+                frame_encoder_push(enc, eia608_control_command(eia608_control_delete_to_end_of_row, DEFAULT_CHANNEL));
+            }
+
+            continue;
+        }
+
+        for (last = SCREEN_COLS - 1; c < last && frame_cell_equal(&shown->cell[r][last], &next->cell[s][last]); --last) {
+        }
+
+        // Rewriting a few unchanged charcters is cheaper than moving the cursor over them
+        for (end = c; end <= last && !frame_cell_empty(&next->cell[s][end]); ++end) {
+            for (same = 0; end + same <= last && frame_cell_equal(&shown->cell[r][end + same], &next->cell[s][end + same]); ++same) {
+            }
+
+            if (4 <= same) {
+                break;
+            }
+        }
+
+        frame_encoder_move(enc, r, c);
+        c = frame_encoder_text(enc, next, s, c, end);
+    }
+}
+
+// A roll-up decoder moves its window to the row of any preamble, which the tracked decoder does not
+// model. So only the base row is written to, and the rows above it are each written there first and
+// then scrolled up by a carriage return. Returns 0 if that can not produce next with rolls returns
+static int frame_encoder_delta_roll_up(frame_encoder_t* enc, caption_frame_t* next, int erase, int rolls)
+{
+    int r, c, base = next->state.row;
+
+    if (0 > base - rolls) {
+        return 0;
+    }
+
+    if (erase) {
+        frame_encoder_push(enc, eia608_control_command(eia608_control_erase_display_memory, DEFAULT_CHANNEL));
+    }
+
+    // carriage return scrolls up from the cursor row
+    if (base != enc->frame->state.row) {
+        frame_encoder_move(enc, base, 0);
+    }
+
+    for (; 0 < rolls; --rolls) {
+        frame_encoder_delta_row(enc, &next->front, base, base - rolls);
+        frame_encoder_push(enc, eia608_control_command(eia608_control_carriage_return, DEFAULT_CHANNEL));
+    }
+
+    frame_encoder_delta_row(enc, &next->front, base, base);
+
+    // leave the cursor where roll-up expects it
+    frame_encoder_move(enc, base, next->state.col);
+
+    for (r = 0; r < SCREEN_ROWS; ++r) {
+        for (c = 0; r != base && c < SCREEN_COLS; ++c) {
+            if (!frame_cell_equal(&enc->frame->front.cell[r][c], &next->front.cell[r][c])) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Returns 0 if the commands do not reach next
+static int frame_encoder_delta(frame_encoder_t* enc, caption_frame_t* next, int erase, int rolls)
+{
+    int r;
+    caption_frame_state_t* state = &enc->frame->state;
+    int mod = CAPTION_ROLL_UP == next->state.mod ? CAPTION_ROLL_UP : CAPTION_PAINT_ON;
+    int rup = CAPTION_ROLL_UP == mod ? next->state.rup : 0;
+    // decoders may clear or move the window when roll-up starts or its base row changes
+    int moved = CAPTION_ROLL_UP != state->mod || next->state.row != state->row;
+
+    enc->noop = CAPTION_ROLL_UP == mod ? eia608_control_command((eia608_control_t)(eia608_control_roll_up_2 + rup - 1), DEFAULT_CHANNEL)
+                                       : eia608_control_command(eia608_control_resume_direct_captioning, DEFAULT_CHANNEL);
+
+    if (CAPTION_ROLL_UP == mod && moved && !erase) {
+        return 0;
+    }
+
+    if (mod != state->mod || rup != state->rup) {
+        frame_encoder_push(enc, enc->noop);
+    }
+
+    if (CAPTION_ROLL_UP == mod) {
+        return frame_encoder_delta_roll_up(enc, next, erase, rolls);
+    }
+
+    if (erase) {
+        frame_encoder_push(enc, eia608_control_command(eia608_control_erase_display_memory, DEFAULT_CHANNEL));
+    }
+
+    for (r = 0; r < SCREEN_ROWS; ++r) {
+        frame_encoder_delta_row(enc, &next->front, r, r);
+    }
+
+    return 1;
+}
+
+size_t caption_frame_delta_608(caption_frame_t* prev, caption_frame_t* next, uint16_t* cc_data, size_t size)
+{
+    int erase, rolls, valid, best_erase = 0, best_rolls = 0;
+    caption_frame_t best, trial;
+    size_t best_count = (size_t)-1;
+    uint16_t trial_data[CAPTION_FRAME_DELTA_CC_DATA_SIZE];
+    int max_rolls = CAPTION_ROLL_UP == next->state.mod ? 1 + next->state.rup : 0;
+
+    // Try erasing first, and scrolling each number of lines, and keep whatever is shortest
+    for (erase = 0; erase < 2; ++erase) {
+        for (rolls = 0; rolls <= max_rolls; ++rolls) {
+            memcpy(&trial, prev, sizeof(caption_frame_t));
+            frame_encoder_t enc = { &trial_data[0], CAPTION_FRAME_DELTA_CC_DATA_SIZE, 0, 0, &trial };
+            valid = frame_encoder_delta(&enc, next, erase, rolls);
+
+            // If nothing reaches next, the last try, which erases and redraws the most, is used
+            if ((valid || (erase && max_rolls == rolls && (size_t)-1 == best_count)) && enc.count < best_count) {
+                best_count = enc.count;
+                best_erase = erase, best_rolls = rolls;
+                memcpy(&best, &trial, sizeof(caption_frame_t));
+                memcpy(cc_data, &trial_data[0], sizeof(uint16_t) * (best_count < size ? best_count : size));
+            }
+        }
+    }
+
+    if (best_count > size) {
+        // Only part of it fits. Encode it again into cc_data, so prev only takes the words that were written
+        memcpy(&best, prev, sizeof(caption_frame_t));
+        frame_encoder_t enc = { cc_data, size, 0, 0, &best };
+        frame_encoder_delta(&enc, next, best_erase, best_rolls);
+        best_count = enc.count;
+    }
+
+    memcpy(prev, &best, sizeof(caption_frame_t));
+    return best_count;
+}
+////////////////////////////////////////////////////////////////////////////////
 size_t caption_frame_to_text(caption_frame_t* frame, utf8_char_t* data)
 {
     int r, c, uln, crlf = 0, count = 0;
@@ -491,7 +813,7 @@ size_t caption_frame_json(caption_frame_t* frame, utf8_char_t* buf)
 
     for (r = 0; r < SCREEN_ROWS; ++r) {
         for (c = 0; c < SCREEN_COLS; ++c) {
-            caption_frame_cell_t* cell = frame_cell(frame, r, c);
+            caption_frame_cell_t* cell = frame_buffer_cell(&frame->front, r, c);
 
             if (cell && 0 != cell->data[0]) {
                 const char* data = ('"' == cell->data[0]) ? "\\\"" : (const char*)&cell->data[0]; //escape quote
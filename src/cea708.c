@@ -24,6 +24,7 @@
 #include "cea708.h"
 #include <memory.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 int cea708_cc_count(user_data_t* data)
 {
@@ -162,6 +163,60 @@ int cea708_add_cc_data(cea708_t* cea708, int valid, cea708_cc_type_t type, uint1
     return 1;
 }
 
+// A slot that carries nothing: marked invalid, or a 608 null pair
+static int cea708_cc_data_is_padding(const cc_data_t* cc)
+{
+    return !cc->cc_valid || (cc_type_dtvcc_packet_data > cc->cc_type && 0x8080 == cc->cc_data);
+}
+
+libcaption_stauts_t cea708_merge_cc_data(cea708_t* cea708, cea708_t* from)
+{
+    int i, j, k, end, count = 0;
+    int to_slot[32], from_slot[32];
+
+    // 608 pairs must all come before DTVCC data, so only slots ahead of the first DTVCC pair are used
+    for (end = 0; end < (int)cea708->user_data.cc_count; ++end) {
+        cc_data_t* slot = &cea708->user_data.cc_data[end];
+
+        if (slot->cc_valid && cc_type_dtvcc_packet_data <= slot->cc_type) {
+            break;
+        }
+    }
+
+    // Find a slot for every pair before touching cea708. A valid padding slot is only
+    // reused for the same field, so field 1 data never lands in a field 2 slot
+    for (i = 0, j = 0; i < (int)from->user_data.cc_count; ++i) {
+        cc_data_t* cc = &from->user_data.cc_data[i];
+
+        if (cea708_cc_data_is_padding(cc) || cc_type_dtvcc_packet_data <= cc->cc_type) {
+            continue;
+        }
+
+        for (; j < end; ++j) {
+            cc_data_t* slot = &cea708->user_data.cc_data[j];
+
+            if (cea708_cc_data_is_padding(slot) && (!slot->cc_valid || slot->cc_type == cc->cc_type)) {
+                break;
+            }
+        }
+
+        if (j == end) {
+            return LIBCAPTION_ERROR;
+        }
+
+        to_slot[count] = j++;
+        from_slot[count] = i;
+        ++count;
+    }
+
+    for (k = 0; k < count; ++k) {
+        cea708->user_data.cc_data[to_slot[k]] = from->user_data.cc_data[from_slot[k]];
+        cea708->user_data.cc_data[to_slot[k]].marker_bits = 0x1F;
+    }
+
+    return LIBCAPTION_OK;
+}
+
 int cea708_render(cea708_t* cea708, uint8_t* data, size_t size)
 {
     int i;
@@ -258,6 +313,11 @@ void cea708_dump(cea708_t* cea708)
 }
 
 libcaption_stauts_t cea708_to_caption_frame(caption_frame_t* frame, cea708_t* cea708, double pts)
+{
+    return cea708_demux(cea708, frame, 0, pts);
+}
+
+libcaption_stauts_t cea708_demux(cea708_t* cea708, caption_frame_t* frame, dtvcc_t* dtvcc, double pts)
 {
     int i, count = cea708_cc_count(&cea708->user_data);
     libcaption_stauts_t status = LIBCAPTION_OK;
@@ -268,11 +328,115 @@ libcaption_stauts_t cea708_to_caption_frame(caption_frame_t* frame, cea708_t* ce
             int valid;
             uint16_t cc_data = cea708_cc_data(&cea708->user_data, i, &valid, &type);
 
-            if (valid && cc_type_ntsc_cc_field_1 == type) {
+            if (!valid) {
+                continue;
+            }
+
+            if (frame && cc_type_ntsc_cc_field_1 == type) {
                 status = libcaption_status_update(status, caption_frame_decode(frame, cc_data, pts));
+            } else if (dtvcc && (cc_type_dtvcc_packet_start == type || cc_type_dtvcc_packet_data == type)) {
+                dtvcc_decode(dtvcc, cc_type_dtvcc_packet_start == type, cc_data);
             }
         }
     }
 
     return status;
 }
+////////////////////////////////////////////////////////////////////////////////
+void cea708_batch_init(cea708_batch_t* batch, size_t capacity)
+{
+    // one allocation, the 16 bit cc_data first to keep it aligned
+    uint8_t* data = calloc(capacity, CEA708_BATCH_STRIDE * (2 + 1 + 1) + 3);
+    batch->size = 0;
+    batch->capacity = capacity;
+    batch->cc_data = (uint16_t*)data;
+    batch->cc_valid = data + capacity * CEA708_BATCH_STRIDE * 2;
+    batch->cc_type = batch->cc_valid + capacity * CEA708_BATCH_STRIDE;
+    batch->cc_count = batch->cc_type + capacity * CEA708_BATCH_STRIDE;
+    batch->em_data = batch->cc_count + capacity;
+    batch->flags = batch->em_data + capacity;
+}
+
+void cea708_batch_free(cea708_batch_t* batch)
+{
+    free(batch->cc_data);
+    memset(batch, 0, sizeof(cea708_batch_t));
+}
+
+void cea708_batch_clear(cea708_batch_t* batch)
+{
+    memset(batch->cc_valid, 0, batch->size * CEA708_BATCH_STRIDE);
+    memset(batch->cc_type, 0, batch->size * CEA708_BATCH_STRIDE);
+    memset(batch->cc_data, 0, batch->size * CEA708_BATCH_STRIDE * sizeof(uint16_t));
+    batch->size = 0;
+}
+
+libcaption_stauts_t cea708_batch_parse(cea708_batch_t* batch, const uint8_t* data, size_t size)
+{
+    size_t i, count;
+
+    // country, provider, user_identifier, user_data_type_code, flags and em_data
+    if (batch->size >= batch->capacity || 10 > size) {
+        return LIBCAPTION_ERROR;
+    }
+
+    if (country_united_states != data[0] || t35_provider_atsc != ((data[1] << 8) | data[2])
+        || GA94 != (uint32_t)((data[3] << 24) | (data[4] << 16) | (data[5] << 8) | data[6]) || 3 != data[7]) {
+        return LIBCAPTION_ERROR;
+    }
+
+    count = data[8] & 0x1F;
+
+    if (10 + 3 * count > size) { // the trailing marker bits are optional
+        return LIBCAPTION_ERROR;
+    }
+
+    uint8_t* cc_valid = cea708_batch_cc_valid(batch, batch->size);
+    uint8_t* cc_type = cea708_batch_cc_type(batch, batch->size);
+    uint16_t* cc_data = cea708_batch_cc_data(batch, batch->size);
+    batch->cc_count[batch->size] = (uint8_t)count;
+    batch->flags[batch->size] = data[8] & 0xE0;
+    batch->em_data[batch->size] = data[9];
+    data += 10;
+
+    for (i = 0; i < count; ++i) {
+        cc_valid[i] = (data[3 * i] >> 2) & 0x01;
+        cc_type[i] = data[3 * i] & 0x03;
+        cc_data[i] = (data[3 * i + 1] << 8) | data[3 * i + 2];
+    }
+
+    return ++batch->size < batch->capacity ? LIBCAPTION_OK : LIBCAPTION_READY;
+}
+
+size_t cea708_batch_render(cea708_batch_t* batch, size_t index, uint8_t* data, size_t size)
+{
+    size_t i, count = batch->cc_count[index];
+    const uint8_t* cc_valid = cea708_batch_cc_valid(batch, index);
+    const uint8_t* cc_type = cea708_batch_cc_type(batch, index);
+    const uint16_t* cc_data = cea708_batch_cc_data(batch, index);
+
+    if (cea708_batch_render_size(batch, index) > size) {
+        return 0;
+    }
+
+    data[0] = country_united_states;
+    data[1] = t35_provider_atsc >> 8;
+    data[2] = t35_provider_atsc >> 0;
+    data[3] = (GA94 >> 24) & 0xFF;
+    data[4] = (GA94 >> 16) & 0xFF;
+    data[5] = (GA94 >> 8) & 0xFF;
+    data[6] = (GA94 >> 0) & 0xFF;
+    data[7] = 3; // user_data_type_code
+    data[8] = batch->flags[index] | (uint8_t)count;
+    data[9] = batch->em_data[index];
+    data += 10;
+
+    for (i = 0; i < count; ++i) {
+        data[3 * i + 0] = 0xF8 | (cc_valid[i] << 2) | cc_type[i]; // marker bits
+        data[3 * i + 1] = cc_data[i] >> 8;
+        data[3 * i + 2] = cc_data[i] >> 0;
+    }
+
+    data[3 * count] = 0xFF; // marker bits
+    return cea708_batch_render_size(batch, index);
+}
@@ -1,22 +1,744 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#include "dvtcc.h"
+#include <stdio.h>
+#include <string.h>
 
+void dtvcc_init(dtvcc_t* dtvcc, dtvcc_service_block_callback_t callback, void* opaque)
+{
+    memset(dtvcc, 0, sizeof(dtvcc_t));
+    dtvcc->sequence_number = -1;
+    dtvcc->callback = callback;
+    dtvcc->opaque = opaque;
+}
+
+// Splits a complete packet into service blocks
+static libcaption_stauts_t dtvcc_packet(dtvcc_t* dtvcc)
+{
+    const uint8_t* data = &dtvcc->packet[1];
+    size_t size = dtvcc->packet_size - 1;
+    dtvcc->sequence_number = dtvcc->packet[0] >> 6;
+
+    while (0 < size) {
+        int service_number = data[0] >> 5;
+        size_t block_size = data[0] & 0x1F;
+        ++data;
+        --size;
+
+        if (7 == service_number) {
+            // extended service block header
+            if (0 == size) {
+                return LIBCAPTION_ERROR;
+            }
+
+            service_number = data[0] & 0x3F;
+            ++data;
+            --size;
+
+            if (7 > service_number) {
+                return LIBCAPTION_ERROR;
+            }
+        }
+
+        // null block header, the rest of the packet is padding
+        if (0 == service_number) {
+            break;
+        }
+
+        if (block_size > size) {
+            return LIBCAPTION_ERROR;
+        }
+
+        if (block_size && dtvcc->callback) {
+            dtvcc->callback(dtvcc->opaque, service_number, data, block_size);
+        }
+
+        data += block_size;
+        size -= block_size;
+    }
+
+    return LIBCAPTION_READY;
+}
+
+libcaption_stauts_t dtvcc_decode(dtvcc_t* dtvcc, int start, uint16_t cc_data)
+{
+    libcaption_stauts_t status = LIBCAPTION_OK;
+
+    if (start) {
+        // a packet still in progress was cut short, drop it
+        if (dtvcc->size) {
+            status = LIBCAPTION_ERROR;
+        }
+
+        // packet_size_code 0 means the largest packet, 128 bytes
+        dtvcc->packet_size = (cc_data & 0x3F00) ? ((cc_data >> 8) & 0x3F) * 2 : DTVCC_MAX_PACKET_SIZE;
+        dtvcc->size = 0;
+    } else if (!dtvcc->size) {
+        return LIBCAPTION_OK;
+    }
+
+    dtvcc->packet[dtvcc->size + 0] = cc_data >> 8;
+    dtvcc->packet[dtvcc->size + 1] = cc_data >> 0;
+    dtvcc->size += 2;
+
+    if (dtvcc->size == dtvcc->packet_size) {
+        dtvcc->size = 0;
+        return libcaption_status_update(status, dtvcc_packet(dtvcc));
+    }
+
+    return status;
+}
+////////////////////////////////////////////////////////////////////////////////
+// Predefined window and pen styles, CEA-708 tables 26 and 27. Index 0 is unused
+typedef struct {
+    uint8_t justify;
+    uint8_t print_direction;
+    uint8_t scroll_direction;
+    uint8_t word_wrap;
+    uint8_t fill_opacity;
+} dtvcc_window_style_t;
+
+static const dtvcc_window_style_t dtvcc_window_style[8] = {
+    { 0, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 0, 0 },
+    { 0, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 0, 0 }, // pop-up
+    { 0, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 0, 3 }, // pop-up, transparent
+    { 2, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 0, 0 }, // pop-up, centered
+    { 0, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 1, 0 }, // roll-up
+    { 0, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 1, 3 }, // roll-up, transparent
+    { 2, dtvcc_direction_left_to_right, dtvcc_direction_bottom_to_top, 1, 0 }, // roll-up, centered
+    { 0, dtvcc_direction_top_to_bottom, dtvcc_direction_right_to_left, 0, 0 }, // ticker tape
+};
+
+typedef struct {
+    uint8_t font_style;
+    uint8_t edge_type;
+    uint8_t bg_opacity;
+} dtvcc_pen_style_t;
+
+static const dtvcc_pen_style_t dtvcc_pen_style[8] = {
+    { 0, 0, 0 },
+    { 0, 0, 0 }, // default
+    { 1, 0, 0 }, // monospaced serif
+    { 2, 0, 0 }, // proportional serif
+    { 3, 0, 0 }, // monospaced sans serif
+    { 4, 0, 0 }, // proportional sans serif
+    { 3, 3, 3 }, // monospaced sans serif, uniform edge, transparent background
+    { 4, 3, 3 }, // proportional sans serif, uniform edge, transparent background
+};
+
+static void dtvcc_window_set_style(dtvcc_window_t* window, int id)
+{
+    window->justify = dtvcc_window_style[id].justify;
+    window->print_direction = dtvcc_window_style[id].print_direction;
+    window->scroll_direction = dtvcc_window_style[id].scroll_direction;
+    window->word_wrap = dtvcc_window_style[id].word_wrap;
+    window->display_effect = 0; // snap
+    window->effect_direction = 0;
+    window->effect_speed = 0;
+    window->fill_color = 0; // black
+    window->fill_opacity = dtvcc_window_style[id].fill_opacity;
+    window->border_type = 0; // none
+    window->border_color = 0;
+}
+
+static void dtvcc_window_set_pen_style(dtvcc_window_t* window, int id)
+{
+    memset(&window->pen, 0, sizeof(dtvcc_cell_t));
+    window->pen.pen_size = 1; // standard
+    window->pen.offset = 1; // normal
+    window->pen.font_style = dtvcc_pen_style[id].font_style;
+    window->pen.edge_type = dtvcc_pen_style[id].edge_type;
+    window->pen.fg_color = 0x3F; // white
+    window->pen.bg_opacity = dtvcc_pen_style[id].bg_opacity;
+}
+////////////////////////////////////////////////////////////////////////////////
+// G2 characters with a unicode equivalent. Transparent spaces leave the cell empty,
+// anything unlisted shows as an underscore, as the spec suggests
+static uint16_t dtvcc_g2_char(uint8_t code)
+{
+    switch (code) {
+    case 0x20: // transparent space
+    case 0x21: // non breaking transparent space
+        return 0;
+    case 0x25: return 0x2026; // horizontal ellipsis
+    case 0x2A: return 0x0160; // S caron
+    case 0x2C: return 0x0152; // OE ligature
+    case 0x30: return 0x2588; // full block
+    case 0x31: return 0x2018; // left single quotation mark
+    case 0x32: return 0x2019; // right single quotation mark
+    case 0x33: return 0x201C; // left double quotation mark
+    case 0x34: return 0x201D; // right double quotation mark
+    case 0x35: return 0x2022; // bullet
+    case 0x39: return 0x2122; // trade mark
+    case 0x3A: return 0x0161; // s caron
+    case 0x3C: return 0x0153; // oe ligature
+    case 0x3D: return 0x2120; // service mark
+    case 0x3F: return 0x0178; // Y diaeresis
+    case 0x76: return 0x215B; // 1/8
+    case 0x77: return 0x215C; // 3/8
+    case 0x78: return 0x215D; // 5/8
+    case 0x79: return 0x215E; // 7/8
+    case 0x7A: return 0x2502; // box drawings
+    case 0x7B: return 0x2510;
+    case 0x7C: return 0x2514;
+    case 0x7D: return 0x2500;
+    case 0x7E: return 0x2518;
+    case 0x7F: return 0x250C;
+    default: return '_';
+    }
+}
+
+// Returns the size of the command at data, or 0 if more bytes are needed to tell
+static size_t dtvcc_command_size(const uint8_t* data, size_t size)
+{
+    uint8_t code = data[0];
+
+    if (0x10 == code) { // EXT1
+        if (2 > size) {
+            return 0;
+        }
+
+        code = data[1];
+
+        if (0x20 > code) { // C2
+            return 2 + (code >> 3);
+        } else if (0x80 > code || 0xA0 <= code) { // G2 and G3
+            return 2;
+        } else if (0x90 > code) { // C3
+            return 0x88 > code ? 6 : 7;
+        } else { // C3 variable length
+            return 3 > size ? 0 : 3 + (data[2] & 0x1F);
+        }
+    }
+
+    if (0x20 > code) { // C0
+        return 0x10 > code ? 1 : (0x18 > code ? 2 : 3);
+    }
+
+    if (0x80 > code || 0xA0 <= code) { // G0 and G1
+        return 1;
+    }
+
+    // C1
+    if (0x88 > code) {
+        return 1; // CWx
+    } else if (0x8E > code) {
+        return 2; // CLW, DSW, HDW, TGW, DLW, DLY
+    } else if (0x90 > code) {
+        return 1; // DLC, RST
+    } else if (0x90 == code || 0x92 == code) {
+        return 3; // SPA, SPL
+    } else if (0x91 == code) {
+        return 4; // SPC
+    } else if (0x97 > code) {
+        return 1; // reserved
+    } else if (0x97 == code) {
+        return 5; // SWA
+    } else {
+        return 7; // DFx
+    }
+}
+////////////////////////////////////////////////////////////////////////////////
+static inline dtvcc_cell_t* dtvcc_service_cell(dtvcc_service_t* service, int w, int r, int c)
+{
+    return &service->cell[w][r][c];
+}
+
+static inline int dtvcc_window_inside(dtvcc_window_t* window, int r, int c)
+{
+    return 0 <= r && r < window->row_count && 0 <= c && c < window->column_count;
+}
+
+static void dtvcc_direction_step(int direction, int* dr, int* dc)
+{
+    (*dr) = dtvcc_direction_top_to_bottom == direction ? 1 : (dtvcc_direction_bottom_to_top == direction ? -1 : 0);
+    (*dc) = dtvcc_direction_left_to_right == direction ? 1 : (dtvcc_direction_right_to_left == direction ? -1 : 0);
+}
+
+// The step along a line, and the step to the next line. A new line appears on the side
+// the text scrolls away from. Print and scroll along the same axis are not allowed, such
+// windows are treated as left to right, bottom to top
+static void dtvcc_window_steps(dtvcc_window_t* window, int* dr, int* dc, int* lr, int* lc)
+{
+    int print_direction = window->print_direction, scroll_direction = window->scroll_direction;
+
+    if ((2 > print_direction) == (2 > scroll_direction)) {
+        print_direction = dtvcc_direction_left_to_right;
+        scroll_direction = dtvcc_direction_bottom_to_top;
+    }
+
+    dtvcc_direction_step(print_direction, dr, dc);
+    dtvcc_direction_step(scroll_direction, lr, lc);
+    (*lr) = -(*lr);
+    (*lc) = -(*lc);
+}
+
+static void dtvcc_window_clear(dtvcc_service_t* service, int w)
+{
+    memset(&service->cell[w][0][0], 0, sizeof(service->cell[w]));
+}
+
+// Moves the window contents one line in the scroll direction
+static void dtvcc_window_scroll(dtvcc_service_t* service, int w, int lr, int lc)
+{
+    int i, j, r, c;
+    dtvcc_window_t* window = &service->window[w];
+
+    for (i = 0; i < window->row_count; ++i) {
+        r = 0 < lr ? i : window->row_count - 1 - i;
+
+        for (j = 0; j < window->column_count; ++j) {
+            c = 0 < lc ? j : window->column_count - 1 - j;
+
+            if (dtvcc_window_inside(window, r + lr, c + lc)) {
+                (*dtvcc_service_cell(service, w, r, c)) = (*dtvcc_service_cell(service, w, r + lr, c + lc));
+            } else {
+                memset(dtvcc_service_cell(service, w, r, c), 0, sizeof(dtvcc_cell_t));
+            }
+        }
+    }
+}
+
+// Puts the pen at the start of its line
+static void dtvcc_window_line_start(dtvcc_window_t* window, int dr, int dc)
+{
+    if (dc) {
+        window->col = 0 < dc ? 0 : window->column_count - 1;
+    } else {
+        window->row = 0 < dr ? 0 : window->row_count - 1;
+    }
+}
+
+static void dtvcc_window_carriage_return(dtvcc_service_t* service, int w)
+{
+    int dr, dc, lr, lc;
+    dtvcc_window_t* window = &service->window[w];
+    dtvcc_window_steps(window, &dr, &dc, &lr, &lc);
+    dtvcc_window_line_start(window, dr, dc);
+    window->row += lr;
+    window->col += lc;
+
+    if (!dtvcc_window_inside(window, window->row, window->col)) {
+        window->row -= lr;
+        window->col -= lc;
+        dtvcc_window_scroll(service, w, lr, lc);
+    }
+}
 
-struct dtvcc_packet_t* dtvcc_packet_start(uint8_t cc_data1, uint8_t cc_data2)
+static libcaption_stauts_t dtvcc_service_touch(dtvcc_service_t* service, int w, int shown)
 {
-    unsigned int packet_size = cc_data1 & 0x3F;
-    packet_size = (0 == packet_size) ? 64 * 8 - 1 : (packet_size * 8 - 1)
+    service->dirty |= (1 << w);
+    return (shown || service->window[w].visible) ? LIBCAPTION_READY : LIBCAPTION_OK;
+}
+
+static libcaption_stauts_t dtvcc_service_char(dtvcc_service_t* service, uint16_t code)
+{
+    int dr, dc, lr, lc, w = service->current;
+
+    if (0 > w) {
+        return LIBCAPTION_OK;
+    }
+
+    dtvcc_window_t* window = &service->window[w];
+
+    if (!dtvcc_window_inside(window, window->row, window->col)) {
+        if (!window->word_wrap) {
+            return LIBCAPTION_OK;
+        }
+
+        dtvcc_window_carriage_return(service, w);
+    }
 
-                                                        unsigned int packet_size_bytes
-        = dtvcc_packet_t* dvtcc = malloc(sizeof(dtvcc_packet_t) + packet_size * 2 - 1);
-    dvtcc->service_number = (cc_data1 0xC0) >> 6;
-    dvtcc->packet_size = packet_size;
-    dvtcc->service_number = DVTCC_SERVICE_NUMBER_UNKNOWN;
+    dtvcc_cell_t* cell = dtvcc_service_cell(service, w, window->row, window->col);
+    (*cell) = window->pen;
+    cell->code = code;
+    dtvcc_window_steps(window, &dr, &dc, &lr, &lc);
+    window->row += dr;
+    window->col += dc;
+    return dtvcc_service_touch(service, w, 0);
 }
 
-void dtvcc_packet_data(struct dtvcc_packet_t* dvtcc, uint8_t cc_data1, uint8_t cc_data2)
+static libcaption_stauts_t dtvcc_service_c0(dtvcc_service_t* service, uint8_t code)
 {
-    if (dvtcc->service_number) {
-        if (7 == dvtcc->service_number) {
-            dvtcc->service_number
+    int i, dr, dc, lr, lc, w = service->current;
+
+    if (0 > w) {
+        return LIBCAPTION_OK;
+    }
+
+    dtvcc_window_t* window = &service->window[w];
+    dtvcc_window_steps(window, &dr, &dc, &lr, &lc);
+
+    switch (code) {
+    case 0x08: // BS
+        if (dtvcc_window_inside(window, window->row - dr, window->col - dc)) {
+            window->row -= dr;
+            window->col -= dc;
+            memset(dtvcc_service_cell(service, w, window->row, window->col), 0, sizeof(dtvcc_cell_t));
+        }
+        break;
+
+    case 0x0C: // FF
+        dtvcc_window_clear(service, w);
+        window->row = 0;
+        window->col = 0;
+        break;
+
+    case 0x0D: // CR
+        dtvcc_window_carriage_return(service, w);
+        break;
+
+    case 0x0E: // HCR
+        if (!dtvcc_window_inside(window, window->row, window->col)) {
+            window->row -= dr;
+            window->col -= dc;
+        }
+
+        dtvcc_window_line_start(window, dr, dc);
+
+        for (i = 0; dtvcc_window_inside(window, window->row + i * dr, window->col + i * dc); ++i) {
+            memset(dtvcc_service_cell(service, w, window->row + i * dr, window->col + i * dc), 0, sizeof(dtvcc_cell_t));
+        }
+        break;
+
+    default: // NUL, ETX and reserved
+        return LIBCAPTION_OK;
+    }
+
+    return dtvcc_service_touch(service, w, 0);
+}
+
+static libcaption_stauts_t dtvcc_service_define_window(dtvcc_service_t* service, int w, const uint8_t* data)
+{
+    dtvcc_window_t* window = &service->window[w];
+    int window_style = (data[5] >> 3) & 0x07, pen_style = data[5] & 0x07;
+    int was_visible = window->defined && window->visible;
+
+    if (!window->defined) {
+        memset(window, 0, sizeof(dtvcc_window_t));
+        dtvcc_window_clear(service, w);
+        window->defined = 1;
+        window_style = window_style ? window_style : 1;
+        pen_style = pen_style ? pen_style : 1;
+    }
+
+    window->visible = (data[0] >> 5) & 0x01;
+    window->row_lock = (data[0] >> 4) & 0x01;
+    window->column_lock = (data[0] >> 3) & 0x01;
+    window->priority = data[0] & 0x07;
+    window->relative_positioning = data[1] >> 7;
+    window->anchor_vertical = data[1] & 0x7F;
+    window->anchor_horizontal = data[2];
+    window->anchor_point = data[3] >> 4;
+    window->row_count = 1 + (data[3] & 0x0F);
+    window->column_count = 1 + (data[4] & 0x3F);
+    window->row_count = DTVCC_WINDOW_ROWS < window->row_count ? DTVCC_WINDOW_ROWS : window->row_count;
+    window->column_count = DTVCC_WINDOW_COLS < window->column_count ? DTVCC_WINDOW_COLS : window->column_count;
+
+    if (window_style) {
+        dtvcc_window_set_style(window, window_style);
+    }
+
+    if (pen_style) {
+        dtvcc_window_set_pen_style(window, pen_style);
+    }
+
+    if (window->row >= window->row_count) {
+        window->row = window->row_count - 1;
+    }
+
+    if (window->col >= window->column_count) {
+        window->col = window->column_count - 1;
+    }
+
+    service->current = w;
+    return dtvcc_service_touch(service, w, was_visible != window->visible);
+}
+
+static libcaption_stauts_t dtvcc_service_windows(dtvcc_service_t* service, uint8_t code, uint8_t windows)
+{
+    int w;
+    libcaption_stauts_t status = LIBCAPTION_OK;
+
+    for (w = 0; w < DTVCC_WINDOW_COUNT; ++w) {
+        dtvcc_window_t* window = &service->window[w];
+        int was_visible = window->visible;
+
+        if (!(windows & (1 << w)) || !window->defined) {
+            continue;
+        }
+
+        switch (code) {
+        case 0x88: // CLW
+            dtvcc_window_clear(service, w);
+            break;
+
+        case 0x89: // DSW
+            window->visible = 1;
+            break;
+
+        case 0x8A: // HDW
+            window->visible = 0;
+            break;
+
+        case 0x8B: // TGW
+            window->visible = !window->visible;
+            break;
+
+        case 0x8C: // DLW
+            memset(window, 0, sizeof(dtvcc_window_t));
+            dtvcc_window_clear(service, w);
+            service->current = w == service->current ? -1 : service->current;
+            break;
+
+        default:
+            return LIBCAPTION_OK;
+        }
+
+        status = libcaption_status_update(status, dtvcc_service_touch(service, w, was_visible != window->visible));
+    }
+
+    return status;
+}
+
+static libcaption_stauts_t dtvcc_service_c1(dtvcc_service_t* service, const uint8_t* data)
+{
+    int w = service->current;
+    uint8_t code = data[0];
+    dtvcc_window_t* window = 0 > w ? 0 : &service->window[w];
+
+    if (0x88 > code) { // CWx
+        if (service->window[code & 0x07].defined) {
+            service->current = code & 0x07;
+        }
+
+        return LIBCAPTION_OK;
+    }
+
+    if (0x8D > code) { // CLW, DSW, HDW, TGW, DLW
+        return dtvcc_service_windows(service, code, data[1]);
+    }
+
+    if (0x8F == code) { // RST deletes every window
+        return dtvcc_service_windows(service, 0x8C, 0xFF);
+    }
+
+    if (0x98 <= code) { // DFx
+        return dtvcc_service_define_window(service, code & 0x07, &data[1]);
+    }
+
+    if (!window) {
+        return LIBCAPTION_OK;
+    }
+
+    switch (code) {
+    case 0x90: // SPA
+        window->pen.text_tag = data[1] >> 4;
+        window->pen.offset = (data[1] >> 2) & 0x03;
+        window->pen.pen_size = data[1] & 0x03;
+        window->pen.italics = data[2] >> 7;
+        window->pen.underline = (data[2] >> 6) & 0x01;
+        window->pen.edge_type = (data[2] >> 3) & 0x07;
+        window->pen.font_style = data[2] & 0x07;
+        return LIBCAPTION_OK;
+
+    case 0x91: // SPC
+        window->pen.fg_opacity = data[1] >> 6;
+        window->pen.fg_color = data[1] & 0x3F;
+        window->pen.bg_opacity = data[2] >> 6;
+        window->pen.bg_color = data[2] & 0x3F;
+        window->pen.edge_color = data[3] & 0x3F;
+        return LIBCAPTION_OK;
+
+    case 0x92: // SPL
+        window->row = data[1] & 0x0F;
+        window->col = data[2] & 0x3F;
+        window->row = window->row < window->row_count ? window->row : window->row_count - 1;
+        window->col = window->col < window->column_count ? window->col : window->column_count - 1;
+        return LIBCAPTION_OK;
+
+    case 0x97: // SWA
+        window->fill_opacity = data[1] >> 6;
+        window->fill_color = data[1] & 0x3F;
+        window->border_type = (data[2] >> 6) | ((data[3] >> 5) & 0x04);
+        window->border_color = data[2] & 0x3F;
+        window->word_wrap = (data[3] >> 6) & 0x01;
+        window->print_direction = (data[3] >> 4) & 0x03;
+        window->scroll_direction = (data[3] >> 2) & 0x03;
+        window->justify = data[3] & 0x03;
+        window->effect_speed = data[4] >> 4;
+        window->effect_direction = (data[4] >> 2) & 0x03;
+        window->display_effect = data[4] & 0x03;
+        return dtvcc_service_touch(service, w, 0);
+
+    default: // DLY, DLC and reserved
+        return LIBCAPTION_OK;
+    }
+}
+
+static libcaption_stauts_t dtvcc_service_command(dtvcc_service_t* service, const uint8_t* data)
+{
+    uint8_t code = data[0];
+
+    if (0x10 == code) { // EXT1
+        code = data[1];
+
+        if (0x20 <= code && 0x80 > code) {
+            return dtvcc_service_char(service, dtvcc_g2_char(code));
+        } else if (0xA0 <= code) {
+            return dtvcc_service_char(service, '_'); // G3, only the [CC] icon is defined
+        }
+
+        return LIBCAPTION_OK; // C2 and C3 are reserved
+    }
+
+    if (0x18 == code) { // P16
+        return dtvcc_service_char(service, (data[1] << 8) | data[2]);
+    }
+
+    if (0x20 > code) {
+        return dtvcc_service_c0(service, code);
+    }
+
+    if (0x80 > code) {
+        return dtvcc_service_char(service, 0x7F == code ? 0x266A : code); // music note
+    }
+
+    if (0xA0 > code) {
+        return dtvcc_service_c1(service, data);
+    }
+
+    return dtvcc_service_char(service, code); // G1 is latin-1
+}
+
+void dtvcc_service_init(dtvcc_service_t* service)
+{
+    memset(service, 0, sizeof(dtvcc_service_t));
+    service->current = -1;
+}
+
+libcaption_stauts_t dtvcc_service_decode(dtvcc_service_t* service, const uint8_t* data, size_t size)
+{
+    size_t command_size;
+    libcaption_stauts_t status = LIBCAPTION_OK;
+
+    while (0 < size) {
+        // finish a command started in an earlier block
+        if (service->pending) {
+            service->command[service->pending] = data[0];
+            ++service->pending;
+            ++data;
+            --size;
+            command_size = dtvcc_command_size(&service->command[0], service->pending);
+
+            if (command_size && command_size <= service->pending) {
+                service->pending = 0;
+                status = libcaption_status_update(status, dtvcc_service_command(service, &service->command[0]));
+            }
+
+            continue;
+        }
+
+        command_size = dtvcc_command_size(data, size);
+
+        if (!command_size || command_size > size) {
+            memcpy(&service->command[0], data, size);
+            service->pending = size;
+            break;
+        }
+
+        status = libcaption_status_update(status, dtvcc_service_command(service, data));
+        data += command_size;
+        size -= command_size;
+    }
+
+    return status;
+}
+////////////////////////////////////////////////////////////////////////////////
+static size_t dtvcc_utf8(uint16_t code, utf8_char_t* data)
+{
+    if (0x80 > code) {
+        data[0] = (utf8_char_t)code;
+        return 1;
+    } else if (0x800 > code) {
+        data[0] = (utf8_char_t)(0xC0 | (code >> 6));
+        data[1] = (utf8_char_t)(0x80 | (code & 0x3F));
+        return 2;
+    }
+
+    data[0] = (utf8_char_t)(0xE0 | (code >> 12));
+    data[1] = (utf8_char_t)(0x80 | ((code >> 6) & 0x3F));
+    data[2] = (utf8_char_t)(0x80 | (code & 0x3F));
+    return 3;
+}
+
+size_t dtvcc_window_to_text(dtvcc_service_t* service, int w, utf8_char_t* data, size_t size)
+{
+    int r, c, cols;
+    size_t total = 0;
+    utf8_char_t buff[3];
+    dtvcc_window_t* window = &service->window[w];
+
+    if (!size) {
+        return 0;
+    }
+
+    for (r = 0; window->defined && r < window->row_count; ++r) {
+        for (cols = window->column_count; 0 < cols && !dtvcc_service_cell(service, w, r, cols - 1)->code; --cols) {
+        }
+
+        for (c = 0; c <= cols; ++c) {
+            uint16_t code = c < cols ? dtvcc_service_cell(service, w, r, c)->code : '\n';
+            size_t bytes = dtvcc_utf8(code ? code : ' ', &buff[0]);
+
+            if (total + bytes >= size) {
+                data[total] = 0;
+                return total;
+            }
+
+            memcpy(&data[total], &buff[0], bytes);
+            total += bytes;
+        }
+    }
+
+    data[total] = 0;
+    return total;
+}
+
+void dtvcc_service_dump(dtvcc_service_t* service)
+{
+    int w;
+    utf8_char_t buff[DTVCC_WINDOW_ROWS * (DTVCC_WINDOW_COLS * 3 + 1) + 1];
+
+    for (w = 0; w < DTVCC_WINDOW_COUNT; ++w) {
+        dtvcc_window_t* window = &service->window[w];
+
+        if (window->defined) {
+            dtvcc_window_to_text(service, w, &buff[0], sizeof(buff));
+            fprintf(stderr, "window %d%s %s %dx%d anchor %d,%d pen %d,%d\n%s", w, w == service->current ? "*" : "",
+                window->visible ? "visible" : "hidden", window->row_count, window->column_count,
+                window->anchor_vertical, window->anchor_horizontal, window->row, window->col, buff);
         }
     }
 }
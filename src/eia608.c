@@ -25,6 +25,63 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#include <emmintrin.h>
+#define EIA608_PARITY_SSE2
+#endif
+////////////////////////////////////////////////////////////////////////////////
+// bulk parity
+#ifdef EIA608_PARITY_SSE2
+// Eight words at a time. Folding each byte onto itself leaves the parity of its low 7 bits
+// in bit 0. The 16 bit shifts pull bits in from the neighbouring byte, but only into the
+// top bits of the low byte, which never reach bit 0.
+static inline __m128i eia608_parity_sse2(__m128i v)
+{
+    __m128i x = _mm_and_si128(v, _mm_set1_epi16(0x7F7F));
+    __m128i p = _mm_xor_si128(x, _mm_srli_epi16(x, 4));
+    p = _mm_xor_si128(p, _mm_srli_epi16(p, 2));
+    p = _mm_xor_si128(p, _mm_srli_epi16(p, 1));
+    // odd parity, so set bit 7 when the count so far is even
+    p = _mm_andnot_si128(p, _mm_set1_epi16(0x0101));
+    return _mm_or_si128(x, _mm_slli_epi16(p, 7));
+}
+#endif
+
+void eia608_parity_words(uint16_t* cc_data, size_t count)
+{
+    size_t i = 0;
+
+#ifdef EIA608_PARITY_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&cc_data[i]);
+        _mm_storeu_si128((__m128i*)&cc_data[i], eia608_parity_sse2(v));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        cc_data[i] = eia608_parity_word(cc_data[i]);
+    }
+}
+
+size_t eia608_parity_varify_words(const uint16_t* cc_data, size_t count)
+{
+    size_t i = 0;
+
+#ifdef EIA608_PARITY_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&cc_data[i]);
+
+        if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(v, eia608_parity_sse2(v)))) {
+            break; // the scalar loop finds which word failed
+        }
+    }
+#endif
+
+    for (; i < count && eia608_parity_varify(cc_data[i]); ++i) {
+    }
+
+    return i;
+}
 ////////////////////////////////////////////////////////////////////////////////
 int eia608_row_map[] = { 10, -1, 0, 1, 2, 3, 11, 12, 13, 14, 4, 5, 6, 7, 8, 9 };
 int eia608_reverse_row_map[] = { 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 0, 6, 7, 8, 9, 1 };
@@ -51,10 +108,10 @@ const char* eia608_style_map[] = {
 static inline uint16_t eia608_row_pramble(int row, int chan, int x, int underline)
 {
     row = eia608_reverse_row_map[row & 0x0F];
-    return eia608_parity(0x1040 | (chan ? 0x0800 : 0x0000) | ((row << 7) & 0x0700) | ((row << 5) & 0x0020)) | ((x << 1) & 0x001E) | (underline ? 0x0001 : 0x0000);
+    return eia608_parity(0x1040 | (chan ? 0x0800 : 0x0000) | ((row << 7) & 0x0700) | ((row << 5) & 0x0020) | ((x << 1) & 0x001E) | (underline ? 0x0001 : 0x0000));
 }
 
-uint16_t eia608_row_column_pramble(int row, int col, int chan, int underline) { return eia608_row_pramble(row, chan, 0x10 | (col / 4), underline); }
+uint16_t eia608_row_column_pramble(int row, int col, int chan, int underline) { return eia608_row_pramble(row, chan, 0x08 | (col / 4), underline); }
 uint16_t eia608_row_style_pramble(int row, eia608_style_t style, int chan, int underline) { return eia608_row_pramble(row, chan, style, underline); }
 
 int eia608_parse_preamble(uint16_t cc_data, int* row, int* col, eia608_style_t* style, int* chan, int* underline)
@@ -112,7 +169,7 @@ uint16_t eia608_control_command(eia608_control_t cmd, int cc)
 ////////////////////////////////////////////////////////////////////////////////
 // text
 static const char* utf8_from_index(int idx) { return (0 <= idx && EIA608_CHAR_COUNT > idx) ? eia608_char_map[idx] : ""; }
-static int eia608_to_index(uint16_t cc_data, int* chan, int* c1, int* c2)
+int eia608_to_index(uint16_t cc_data, int* chan, int* c1, int* c2)
 {
     (*c1) = (*c2) = -1;
     (*chan) = 0;
@@ -157,12 +214,21 @@ static int eia608_to_index(uint16_t cc_data, int* chan, int* c1, int* c2)
     return 0;
 }
 
-int eia608_to_utf8(uint16_t c, int* chan, char* str1, char* str2)
+int eia608_to_char(uint16_t c, int* chan, const utf8_char_t** char1, const utf8_char_t** char2)
 {
     int c1, c2;
-    int size = (int)eia608_to_index(c, chan, &c1, &c2);
-    strncpy(str1, utf8_from_index(c1), 5);
-    strncpy(str2, utf8_from_index(c2), 5);
+    int size = eia608_to_index(c, chan, &c1, &c2);
+    (*char1) = utf8_from_index(c1);
+    (*char2) = utf8_from_index(c2);
+    return size;
+}
+
+int eia608_to_utf8(uint16_t c, int* chan, char* str1, char* str2)
+{
+    const utf8_char_t *char1, *char2;
+    int size = eia608_to_char(c, chan, &char1, &char2);
+    strncpy(str1, char1, 5);
+    strncpy(str2, char2, 5);
     return size;
 }
 
@@ -175,11 +241,123 @@ uint16_t eia608_from_basicna(uint16_t bna1, uint16_t bna2)
     return eia608_parity(((0xFF00 & bna1) >> 0) | ((0xFF00 & bna2) >> 8));
 }
 
-// prototype for re2c generated function
-uint16_t _eia608_from_utf8(const utf8_char_t* s);
+// Direct lookup equivalent of the re2c generated _eia608_from_utf8(). The tables are
+// generated from it by examples/utf8bench --generate, and checked by --verify
+static const uint16_t eia608_from_ascii[128] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x2000, 0x2100, 0x2200, 0x2300, 0x2400, 0x2500, 0x2600, 0x1229,
+    0x2800, 0x2900, 0x1228, 0x2B00, 0x2C00, 0x2D00, 0x2E00, 0x2F00,
+    0x3000, 0x3100, 0x3200, 0x3300, 0x3400, 0x3500, 0x3600, 0x3700,
+    0x3800, 0x3900, 0x3A00, 0x3B00, 0x3C00, 0x3D00, 0x3E00, 0x3F00,
+    0x4000, 0x4100, 0x4200, 0x4300, 0x4400, 0x4500, 0x4600, 0x4700,
+    0x4800, 0x4900, 0x4A00, 0x4B00, 0x4C00, 0x4D00, 0x4E00, 0x4F00,
+    0x5000, 0x5100, 0x5200, 0x5300, 0x5400, 0x5500, 0x5600, 0x5700,
+    0x5800, 0x5900, 0x5A00, 0x5B00, 0x132B, 0x5D00, 0x132C, 0x132D,
+    0x1226, 0x6100, 0x6200, 0x6300, 0x6400, 0x6500, 0x6600, 0x6700,
+    0x6800, 0x6900, 0x6A00, 0x6B00, 0x6C00, 0x6D00, 0x6E00, 0x6F00,
+    0x7000, 0x7100, 0x7200, 0x7300, 0x7400, 0x7500, 0x7600, 0x7700,
+    0x7800, 0x7900, 0x7A00, 0x1329, 0x132E, 0x132A, 0x132F, 0x0000,
+};
+
+// indexed by (lead - 0xC2) * 64 + (continuation & 0x3F)
+static const uint16_t eia608_from_utf8_2byte[128] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x1139, 0x1227, 0x1135, 0x1136, 0x1336, 0x1335, 0x1337, 0x0000,
+    0x0000, 0x122B, 0x0000, 0x123E, 0x0000, 0x0000, 0x1130, 0x0000,
+    0x1131, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x123F, 0x0000, 0x1132, 0x0000, 0x1133,
+    0x1230, 0x1220, 0x1231, 0x1320, 0x1330, 0x1338, 0x0000, 0x1232,
+    0x1233, 0x1221, 0x1234, 0x1235, 0x1323, 0x1322, 0x1237, 0x1238,
+    0x0000, 0x7D00, 0x1325, 0x1222, 0x123A, 0x1327, 0x1332, 0x0000,
+    0x133A, 0x123B, 0x1223, 0x123D, 0x1224, 0x0000, 0x0000, 0x1334,
+    0x1138, 0x2A00, 0x113B, 0x1321, 0x1331, 0x1339, 0x0000, 0x7B00,
+    0x113A, 0x5C00, 0x113C, 0x1236, 0x1324, 0x5E00, 0x113D, 0x1239,
+    0x0000, 0x7E00, 0x1326, 0x5F00, 0x113E, 0x1328, 0x1333, 0x7C00,
+    0x133B, 0x123C, 0x6000, 0x113F, 0x1225, 0x0000, 0x0000, 0x0000,
+};
+
+// three byte sequences, perfect hash on code point % 43
+#define EIA608_FROM_UTF8_3BYTE_MOD 43
+static const uint16_t eia608_from_utf8_3byte[43][2] = {
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x2018, 0x1226 },
+    { 0x2019, 0x2700 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x201C, 0x122E },
+    { 0x201D, 0x122F },
+    { 0x2120, 0x122C },
+    { 0x0000, 0x0000 },
+    { 0x2122, 0x1134 },
+    { 0x0000, 0x0000 },
+    { 0x2022, 0x122D },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x2588, 0x7F00 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x250C, 0x133C },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x2510, 0x133D },
+    { 0x0000, 0x0000 },
+    { 0x266A, 0x1137 },
+    { 0x0000, 0x0000 },
+    { 0x2514, 0x133E },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x2518, 0x133F },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x0000, 0x0000 },
+    { 0x2014, 0x122A },
+};
+
+uint16_t _eia608_from_utf8_table(const utf8_char_t* s)
+{
+    const uint8_t* c = (const uint8_t*)s;
+
+    if (!c) {
+        return 0x0000;
+    }
+
+    if (0x80 > c[0]) {
+        return eia608_from_ascii[c[0]];
+    }
+
+    if ((0xC2 == c[0] || 0xC3 == c[0]) && 0x80 == (c[1] & 0xC0)) {
+        return eia608_from_utf8_2byte[((c[0] - 0xC2) << 6) | (c[1] & 0x3F)];
+    }
+
+    if (0xE2 == c[0] && 0x80 == (c[1] & 0xC0) && 0x80 == (c[2] & 0xC0)) {
+        uint16_t code = 0x2000 | ((c[1] & 0x3F) << 6) | (c[2] & 0x3F);
+        const uint16_t* entry = eia608_from_utf8_3byte[code % EIA608_FROM_UTF8_3BYTE_MOD];
+        return code == entry[0] ? entry[1] : 0x0000;
+    }
+
+    return 0x0000;
+}
+
 uint16_t eia608_from_utf8_1(const utf8_char_t* c, int chan)
 {
-    uint16_t cc_data = _eia608_from_utf8(c);
+    uint16_t cc_data = _eia608_from_utf8_table(c);
 
     if (0 == cc_data) {
         return cc_data;
@@ -194,8 +372,8 @@ uint16_t eia608_from_utf8_1(const utf8_char_t* c, int chan)
 
 uint16_t eia608_from_utf8_2(const utf8_char_t* c1, const utf8_char_t* c2)
 {
-    uint16_t cc1 = _eia608_from_utf8(c1);
-    uint16_t cc2 = _eia608_from_utf8(c2);
+    uint16_t cc1 = _eia608_from_utf8_table(c1);
+    uint16_t cc2 = _eia608_from_utf8_table(c2);
     return eia608_from_basicna(cc1, cc2);
 }
 ////////////////////////////////////////////////////////////////////////////////
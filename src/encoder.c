@@ -0,0 +1,157 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#include "encoder.h"
+#include "eia608.h"
+#include "utf8.h"
+#include <string.h>
+
+#define DEFAULT_CHANNEL 0
+#define PAINT_ON_ROW (SCREEN_ROWS - CAPTION_ENCODER_PAINT_ON_ROWS)
+
+// The target frame is driven through the decoder, so it always matches what the commands we send will do
+static void caption_encoder_decode(caption_encoder_t* enc, uint16_t cc_data)
+{
+    enc->frame.state.cc_data = 0; // never skipped as a repeat
+    caption_frame_decode(&enc->frame, cc_data, 0.0);
+}
+
+static void caption_encoder_command(caption_encoder_t* enc, eia608_control_t cmd)
+{
+    caption_encoder_decode(enc, eia608_control_command(cmd, DEFAULT_CHANNEL));
+}
+
+void caption_encoder_init(caption_encoder_t* enc, caption_encoder_mode_t mode)
+{
+    enc->mode = mode;
+    enc->newline = 0;
+    caption_frame_init(&enc->shown);
+    caption_frame_init(&enc->frame);
+
+    if (caption_encoder_paint_on == mode) {
+        caption_encoder_command(enc, eia608_control_resume_direct_captioning);
+        caption_encoder_decode(enc, eia608_row_column_pramble(PAINT_ON_ROW, 0, DEFAULT_CHANNEL, 0));
+    } else {
+        caption_encoder_command(enc, (eia608_control_t)(eia608_control_roll_up_2 + (mode - caption_encoder_roll_up_2)));
+    }
+}
+
+static void caption_encoder_newline(caption_encoder_t* enc)
+{
+    enc->newline = 0;
+
+    if (caption_encoder_paint_on != enc->mode) {
+        caption_encoder_command(enc, eia608_control_carriage_return);
+    } else if (SCREEN_ROWS - 1 > enc->frame.state.row) {
+        caption_encoder_decode(enc, eia608_row_column_pramble(enc->frame.state.row + 1, 0, DEFAULT_CHANNEL, 0));
+    } else {
+        caption_encoder_command(enc, eia608_control_erase_display_memory);
+        caption_encoder_decode(enc, eia608_row_column_pramble(PAINT_ON_ROW, 0, DEFAULT_CHANNEL, 0));
+    }
+}
+
+// Number of charcters up to the next whitespace
+static int caption_encoder_word_length(const utf8_char_t* text)
+{
+    int count = 0;
+
+    for (; text && *text && !utf8_char_whitespace(text); text = utf8_char_next(text)) {
+        ++count;
+    }
+
+    return count;
+}
+
+size_t caption_encoder_write(caption_encoder_t* enc, const utf8_char_t* text, uint16_t* cc_data, size_t size)
+{
+    size_t count = 0;
+    caption_frame_state_t* state = &enc->frame.state;
+
+    for (; text && *text; text = utf8_char_next(text)) {
+        if ('\n' == *text || '\r' == *text) {
+            enc->newline = 0 < state->col; // blank lines are not sent
+        } else if ('\b' == *text) {
+            if (enc->newline) {
+                enc->newline = 0; // take back the line break
+            } else if (0 < state->col) {
+                caption_encoder_command(enc, eia608_control_backspace);
+            }
+        } else if (utf8_char_whitespace(text)) {
+            // dont start a line with a space
+            if (0 < state->col && !enc->newline && SCREEN_COLS > state->col) {
+                caption_frame_write_char(&enc->frame, state->row, state->col, eia608_style_white, 0, EIA608_CHAR_SPACE);
+                ++state->col;
+            }
+        } else {
+            const utf8_char_t* prev = caption_frame_read_char(&enc->frame, state->row, state->col - 1, 0, 0);
+
+            // wrap the whole word if this is its first charcter, otherwise break it at the edge of the screen
+            if (0 == state->col || !*prev || utf8_char_whitespace(prev)) {
+                enc->newline |= 0 < state->col && SCREEN_COLS < state->col + caption_encoder_word_length(text);
+            }
+
+            enc->newline |= SCREEN_COLS <= state->col;
+
+            if (enc->newline) {
+                // send what we have, so no line is lost if this scrolls it out of the window
+                count += caption_frame_delta_608(&enc->shown, &enc->frame, &cc_data[count], size - count);
+                caption_encoder_newline(enc);
+            }
+
+            if (caption_frame_write_char(&enc->frame, state->row, state->col, eia608_style_white, 0, text)) {
+                ++state->col;
+            }
+        }
+    }
+
+    return count + caption_frame_delta_608(&enc->shown, &enc->frame, &cc_data[count], size - count);
+}
+
+libcaption_stauts_t caption_encoder_push(caption_encoder_t* enc, caption_scheduler_t* sched, const utf8_char_t* text)
+{
+    caption_frame_t shown;
+    uint16_t cc_data[CAPTION_FRAME_DELTA_CC_DATA_SIZE];
+    memcpy(&shown, &enc->shown, sizeof(caption_frame_t));
+    size_t count = caption_encoder_write(enc, text, &cc_data[0], CAPTION_FRAME_DELTA_CC_DATA_SIZE);
+
+    if (LIBCAPTION_OK != caption_scheduler_push(sched, &cc_data[0], count)) {
+        memcpy(&enc->shown, &shown, sizeof(caption_frame_t));
+        return LIBCAPTION_ERROR;
+    }
+
+    return LIBCAPTION_OK;
+}
+
+size_t caption_encoder_clear(caption_encoder_t* enc, uint16_t* cc_data, size_t size)
+{
+    enc->newline = 0;
+    caption_encoder_command(enc, eia608_control_erase_display_memory);
+
+    if (caption_encoder_paint_on == enc->mode) {
+        caption_encoder_decode(enc, eia608_row_column_pramble(PAINT_ON_ROW, 0, DEFAULT_CHANNEL, 0));
+    } else {
+        enc->frame.state.col = 0;
+    }
+
+    return caption_frame_delta_608(&enc->shown, &enc->frame, cc_data, size);
+}
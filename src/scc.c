@@ -116,3 +116,222 @@ size_t scc_to_608(scc_t** scc, const utf8_char_t* data)
 
     return size;
 }
+////////////////////////////////////////////////////////////////////////////////
+double scc_timecode_to_timestamp(int hh, int mm, int ss, int ff, int drop_frame)
+{
+    int64_t minutes = hh * 60 + mm;
+    int64_t frames = ((minutes * 60) + ss) * 30 + ff;
+
+    if (drop_frame) {
+        frames -= 2 * (minutes - (minutes / 10));
+    }
+
+    return frames * (1001.0 / 30000.0);
+}
+
+int scc_reader_init(scc_reader_t* reader, const utf8_char_t* data, size_t size)
+{
+    const utf8_char_t* end = memchr(data, '\0', size);
+    reader->data = data;
+    reader->end = end ? end : data + size;
+    reader->drop_frame = 0;
+    reader->parity_errors = 0;
+    reader->scc = 0;
+
+    if (18 > reader->end - data || 0 != memcmp(data, "Scenarist_SCC V1.0", 18)) {
+        return 0;
+    }
+
+    reader->data += 18;
+    return 1;
+}
+
+void scc_reader_free(scc_reader_t* reader) { reader->scc = scc_free(reader->scc); }
+
+// -1 for anything that is not a hex digit
+#define SCC_H(C) ('0' <= (C) && '9' >= (C) ? (C) - '0' : 'a' <= (C) && 'f' >= (C) ? (C) - 'a' + 10 : 'A' <= (C) && 'F' >= (C) ? (C) - 'A' + 10 : -1)
+#define SCC_H4(C) SCC_H(C), SCC_H(C + 1), SCC_H(C + 2), SCC_H(C + 3)
+#define SCC_H16(C) SCC_H4(C), SCC_H4(C + 4), SCC_H4(C + 8), SCC_H4(C + 12)
+#define SCC_H64(C) SCC_H16(C), SCC_H16(C + 16), SCC_H16(C + 32), SCC_H16(C + 48)
+static const int8_t scc_hex_table[256] = { SCC_H64(0), SCC_H64(64), SCC_H64(128), SCC_H64(192) };
+
+// Four hex digits, negative if any of them is not one
+static inline int32_t scc_hex_word(const utf8_char_t* data)
+{
+    const uint8_t* c = (const uint8_t*)data;
+    int32_t h0 = scc_hex_table[c[0]], h1 = scc_hex_table[c[1]], h2 = scc_hex_table[c[2]], h3 = scc_hex_table[c[3]];
+    return 0 > (h0 | h1 | h2 | h3) ? -1 : (h0 << 12) | (h1 << 8) | (h2 << 4) | h3;
+}
+
+static inline int scc_is_space(utf8_char_t c) { return ' ' == c || '\t' == c; }
+static inline int scc_is_digit(utf8_char_t c) { return '0' <= c && '9' >= c; }
+
+// One or two digits then the separator, returns 0 if that is not what is there
+static const utf8_char_t* scc_timecode_field(const utf8_char_t* data, const utf8_char_t* end, int* value, utf8_char_t* separator)
+{
+    if (data >= end || !scc_is_digit(data[0])) {
+        return 0;
+    }
+
+    (*value) = *data++ - '0';
+
+    if (data < end && scc_is_digit(data[0])) {
+        (*value) = (*value) * 10 + (*data++ - '0');
+    }
+
+    if (separator) {
+        if (data >= end || (':' != data[0] && ';' != data[0])) {
+            return 0;
+        }
+
+        (*separator) = *data++;
+    }
+
+    return data;
+}
+
+// Words that fail the parity check, the runs of good words between them are checked in bulk
+static size_t scc_parity_errors(const uint16_t* cc_data, size_t count)
+{
+    size_t i, errors = 0;
+
+    for (i = eia608_parity_varify_words(cc_data, count); i < count; i += 1 + eia608_parity_varify_words(&cc_data[i + 1], count - i - 1)) {
+        ++errors;
+    }
+
+    return errors;
+}
+
+scc_t* scc_reader_next(scc_reader_t* reader)
+{
+    int hh, mm, ss, ff;
+    utf8_char_t separator;
+    const utf8_char_t *data, *line, *end = reader->end;
+
+    for (data = reader->data; data < end;) {
+        for (line = data; data < end && '\r' != data[0] && '\n' != data[0]; ++data) {
+        }
+
+        const utf8_char_t* line_end = data;
+
+        for (; data < end && ('\r' == data[0] || '\n' == data[0]); ++data) {
+        }
+
+        if (!(line = scc_timecode_field(line, line_end, &hh, &separator)) || !(line = scc_timecode_field(line, line_end, &mm, &separator))
+            || !(line = scc_timecode_field(line, line_end, &ss, &separator)) || !(line = scc_timecode_field(line, line_end, &ff, 0))) {
+            continue;
+        }
+
+        // Every word takes at least four bytes
+        int cc_count = (int)((line_end - line) / 4);
+        reader->scc = scc_relloc(reader->scc, cc_count);
+        reader->scc->cc_size = 0;
+
+        while ((int)reader->scc->cc_size < cc_count) {
+            for (; line < line_end && scc_is_space(line[0]); ++line) {
+            }
+
+            int32_t cc_data = 4 <= line_end - line ? scc_hex_word(line) : -1;
+
+            if (0 > cc_data) {
+                break;
+            }
+
+            reader->scc->cc_data[reader->scc->cc_size++] = (uint16_t)cc_data;
+            line += 4;
+        }
+
+        if (0 == reader->scc->cc_size) {
+            continue;
+        }
+
+        // decoders drop these words, they are counted so a damaged file can be reported
+        reader->parity_errors += scc_parity_errors(reader->scc->cc_data, reader->scc->cc_size);
+        reader->drop_frame = ';' == separator;
+        reader->scc->timestamp = scc_timecode_to_timestamp(hh, mm, ss, ff, reader->drop_frame);
+        reader->data = data;
+        return reader->scc;
+    }
+
+    reader->data = end;
+    return 0;
+}
+////////////////////////////////////////////////////////////////////////////////
+void scc_writer_init(scc_writer_t* writer, utf8_writer_t* output, int drop_frame)
+{
+    writer->writer = output;
+    writer->drop_frame = drop_frame;
+    writer->frame = -1;
+    utf8_writer_write(output, "Scenarist_SCC V1.0\r\n", 20);
+}
+
+static inline void scc_format_2digits(utf8_char_t* data, int value)
+{
+    data[0] = (utf8_char_t)('0' + value / 10);
+    data[1] = (utf8_char_t)('0' + value % 10);
+}
+
+// The inverse of scc_timecode_to_timestamp
+static size_t scc_format_timecode(utf8_char_t* data, int64_t frame, int drop_frame)
+{
+    if (drop_frame) {
+        // add back the frame numbers that were skipped, 18 per ten minutes and 2 for each other minute
+        int64_t tens = frame / 17982, rest = frame % 17982;
+        frame += 18 * tens + (2 <= rest ? 2 * ((rest - 2) / 1798) : 0);
+    }
+
+    // hours wrap at 100, there are only two digits for them
+    scc_format_2digits(&data[0], (int)((frame / 108000) % 100));
+    data[2] = ':';
+    scc_format_2digits(&data[3], (int)((frame / 1800) % 60));
+    data[5] = ':';
+    scc_format_2digits(&data[6], (int)((frame / 30) % 60));
+    data[8] = drop_frame ? ';' : ':';
+    scc_format_2digits(&data[9], (int)(frame % 30));
+    return 11;
+}
+
+void scc_writer_write(scc_writer_t* writer, double timestamp, uint16_t cc_data)
+{
+    static const char hex[] = "0123456789abcdef";
+    int64_t frame = 0 < timestamp ? (int64_t)(timestamp * (30000.0 / 1001.0) + 0.5) : 0;
+    utf8_char_t data[24];
+    size_t size = 0;
+
+    if (0x8080 == cc_data || 0x0000 == cc_data) {
+        return;
+    }
+
+    if (0 > writer->frame || frame > writer->frame) {
+        // a gap, end the current line and start a new one after a blank line
+        if (0 <= writer->frame) {
+            data[size++] = '\r';
+            data[size++] = '\n';
+        }
+
+        data[size++] = '\r';
+        data[size++] = '\n';
+        size += scc_format_timecode(&data[size], frame, writer->drop_frame);
+        data[size++] = '\t';
+        writer->frame = frame;
+    } else {
+        data[size++] = ' ';
+    }
+
+    data[size++] = hex[(cc_data >> 12) & 0x0F];
+    data[size++] = hex[(cc_data >> 8) & 0x0F];
+    data[size++] = hex[(cc_data >> 4) & 0x0F];
+    data[size++] = hex[cc_data & 0x0F];
+    writer->frame += 1;
+    utf8_writer_write(writer->writer, &data[0], size);
+}
+
+int scc_writer_flush(scc_writer_t* writer)
+{
+    if (0 <= writer->frame) {
+        utf8_writer_write(writer->writer, "\r\n", 2);
+        writer->frame = -1;
+    }
+
+    return utf8_writer_flush(writer->writer);
+}
@@ -0,0 +1,122 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#include "scheduler.h"
+#include "eia608.h"
+#include <string.h>
+
+void caption_scheduler_init(caption_scheduler_t* sched, double fps)
+{
+    memset(sched, 0, sizeof(caption_scheduler_t));
+    sched->fps = fps;
+    sched->rate = EIA608_PAIRS_PER_SECOND / fps;
+    // 29.97 is often written for 30000/1001. Snap to the nearest quarter so we never run over the line rate
+    int quarters = (int)(sched->rate * 4 + 0.5);
+
+    if (-0.001 < sched->rate * 4 - quarters && sched->rate * 4 - quarters < 0.001) {
+        sched->rate = quarters / 4.0;
+    }
+
+    // 9600 bits per second, 3 bytes per cc_data
+    sched->cc_count = (int)(600.0 / fps + 0.5);
+    sched->cc_count = 31 < sched->cc_count ? 31 : 1 > sched->cc_count ? 1 : sched->cc_count;
+}
+
+libcaption_stauts_t caption_scheduler_push(caption_scheduler_t* sched, const uint16_t* cc_data, size_t count)
+{
+    size_t i;
+
+    if (CAPTION_SCHEDULER_SIZE < sched->size + count) {
+        return LIBCAPTION_ERROR;
+    }
+
+    for (i = 0; i < count; ++i) {
+        sched->cc_data[(sched->head + sched->size + i) & (CAPTION_SCHEDULER_SIZE - 1)] = cc_data[i];
+    }
+
+    sched->size += count;
+    return LIBCAPTION_OK;
+}
+
+libcaption_stauts_t caption_scheduler_push_frame(caption_scheduler_t* sched, caption_frame_t* frame)
+{
+    uint16_t cc_data[CAPTION_FRAME_CC_DATA_SIZE];
+    size_t count = caption_frame_to_608(frame, &cc_data[0], CAPTION_FRAME_CC_DATA_SIZE);
+    return caption_scheduler_push(sched, &cc_data[0], count);
+}
+
+libcaption_stauts_t caption_scheduler_push_delta(caption_scheduler_t* sched, caption_frame_t* shown, caption_frame_t* frame)
+{
+    caption_frame_t prev;
+    uint16_t cc_data[CAPTION_FRAME_DELTA_CC_DATA_SIZE];
+    memcpy(&prev, shown, sizeof(caption_frame_t));
+    size_t count = caption_frame_delta_608(shown, frame, &cc_data[0], CAPTION_FRAME_DELTA_CC_DATA_SIZE);
+
+    if (LIBCAPTION_OK != caption_scheduler_push(sched, &cc_data[0], count)) {
+        memcpy(shown, &prev, sizeof(caption_frame_t));
+        return LIBCAPTION_ERROR;
+    }
+
+    return LIBCAPTION_OK;
+}
+
+libcaption_stauts_t caption_scheduler_push_clear(caption_scheduler_t* sched)
+{
+    uint16_t cc_data = eia608_control_command(eia608_control_erase_display_memory, 0);
+    return caption_scheduler_push(sched, &cc_data, 1);
+}
+
+double caption_scheduler_display_time(caption_scheduler_t* sched, double timestamp)
+{
+    if (!sched->size) {
+        return timestamp;
+    }
+
+    // The next frame carries floor(credit + rate) cc_data, the one after floor(credit + 2 * rate), etc.
+    double need = (sched->size - sched->credit) / sched->rate;
+    size_t frames = (size_t)need;
+    frames += frames < need ? 1 : 0;
+    return timestamp + (1 < frames ? frames - 1 : 0) / sched->fps;
+}
+
+int caption_scheduler_next(caption_scheduler_t* sched, cea708_t* cea708)
+{
+    int i, sent = 0;
+    cea708_init(cea708);
+    sched->credit += sched->rate;
+
+    for (i = 0; i < sched->cc_count; ++i) {
+        if (1.0 > sched->credit) {
+            cea708_add_cc_data(cea708, 0, cc_type_dtvcc_packet_data, 0x0000);
+        } else if (sched->size) {
+            cea708_add_cc_data(cea708, 1, cc_type_ntsc_cc_field_1, sched->cc_data[sched->head]);
+            sched->head = (sched->head + 1) & (CAPTION_SCHEDULER_SIZE - 1);
+            sched->credit -= 1.0, --sched->size, ++sent;
+        } else {
+            cea708_add_cc_data(cea708, 1, cc_type_ntsc_cc_field_1, 0x8080);
+            sched->credit -= 1.0;
+        }
+    }
+
+    return sent;
+}
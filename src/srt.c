@@ -23,6 +23,7 @@
 /**********************************************************************************************/
 #include "srt.h"
 #include "utf8.h"
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,7 +31,13 @@
 srt_t* srt_new(const utf8_char_t* data, size_t size, double timestamp, srt_t* prev, srt_t** head)
 {
     srt_t* srt = malloc(sizeof(srt_t) + size + 1);
+
+    if (!srt) {
+        return 0;
+    }
+
     srt->next = 0;
+    srt->arena = 0;
     srt->duration = 0;
     srt->aloc = size;
     srt->timestamp = timestamp;
@@ -61,83 +68,451 @@ srt_t* srt_new(const utf8_char_t* data, size_t size, double timestamp, srt_t* pr
 srt_t* srt_free_head(srt_t* head)
 {
     srt_t* next = head->next;
-    free(head);
+
+    if (!head->arena) {
+        free(head);
+    }
+
     return next;
 }
 
 void srt_free(srt_t* srt)
 {
+    srt_t* arena = 0;
+
     while (srt) {
+        if (srt->arena) {
+            arena = srt->arena;
+        }
+
         srt = srt_free_head(srt);
     }
+
+    free(arena);
+}
+////////////////////////////////////////////////////////////////////////////////
+// parser
+// Cues are packed back to back in one block, each followed by its text
+#define SRT_ARENA_ALIGN 8
+#define SRT_ARENA_MIN_SIZE 4096
+static inline size_t srt_arena_cue_size(size_t text_size) { return (sizeof(srt_t) + text_size + 1 + SRT_ARENA_ALIGN - 1) & ~(size_t)(SRT_ARENA_ALIGN - 1); }
+
+// Returns the start of the next line. blank is set if the line holds nothing but whitespace.
+// Line endings are the same as utf8_line_length
+static const utf8_char_t* srt_next_line(const utf8_char_t* data, const utf8_char_t* end, int* blank)
+{
+    (*blank) = 1;
+
+    for (; data < end; ++data) {
+        if ('\r' == data[0] || '\n' == data[0]) {
+            utf8_char_t pair = '\r' == data[0] ? '\n' : '\r';
+            ++data;
+
+            if (data < end && pair == data[0]) {
+                ++data;
+            }
+
+            break;
+        }
+
+        if (' ' < (uint8_t)data[0]) {
+            (*blank) = 0;
+        }
+    }
+
+    return data;
+}
+
+static inline int srt_is_digit(utf8_char_t c) { return '0' <= c && '9' >= c; }
+static inline const utf8_char_t* srt_skip_space(const utf8_char_t* data, const utf8_char_t* end)
+{
+    for (; data < end && (' ' == data[0] || '\t' == data[0]); ++data) {
+    }
+
+    return data;
+}
+
+// Reads up to max digits, returns 0 if there were none
+static const utf8_char_t* srt_parse_digits(const utf8_char_t* data, const utf8_char_t* end, int max, int* value)
+{
+    const utf8_char_t* start = data;
+
+    for ((*value) = 0; data < end && data - start < max && srt_is_digit(data[0]); ++data) {
+        (*value) = (*value) * 10 + (data[0] - '0');
+    }
+
+    return data == start ? 0 : data;
 }
 
 #define SRTTIME2SECONDS(HH, MM, SS, MS) ((HH * 3600.0) + (MM * 60.0) + SS + (MS / 1000.0))
+// HH:MM:SS,mmm where hours may have any number of digits and the millisecond separator may be '.'
+// If hours_optional is set, as in WebVTT, MM:SS.mmm is accepted too
+static const utf8_char_t* srt_parse_time(const utf8_char_t* data, const utf8_char_t* end, int hours_optional, double* time)
+{
+    int hh, mm, ss, ms;
+    data = srt_skip_space(data, end);
+
+    if (!(data = srt_parse_digits(data, end, 9, &hh)) || data >= end || ':' != *data++
+        || !(data = srt_parse_digits(data, end, 2, &mm)) || data >= end) {
+        return 0;
+    }
+
+    if (':' == data[0]) {
+        data = srt_parse_digits(data + 1, end, 2, &ss);
+    } else if (hours_optional) {
+        ss = mm, mm = hh, hh = 0;
+    } else {
+        return 0;
+    }
+
+    if (!data || data >= end || (',' != data[0] && '.' != data[0]) || !(data = srt_parse_digits(data + 1, end, 3, &ms))) {
+        return 0;
+    }
+
+    (*time) = SRTTIME2SECONDS(hh, mm, ss, ms);
+    return data;
+}
+
+static int srt_parse_timing(const utf8_char_t* data, const utf8_char_t* end, int hours_optional, double* str_pts, double* end_pts)
+{
+    double str, stp;
+
+    if (!(data = srt_parse_time(data, end, hours_optional, &str))) {
+        return 0;
+    }
+
+    data = srt_skip_space(data, end);
+
+    if (3 > end - data || 0 != memcmp(data, "-->", 3) || !srt_parse_time(data + 3, end, hours_optional, &stp)) {
+        return 0;
+    }
+
+    (*str_pts) = str;
+    (*end_pts) = stp;
+    return 1;
+}
+
+// Cues are added to one block as they are parsed
+typedef struct {
+    uint8_t* block;
+    size_t used, aloc, prev;
+} srt_arena_t;
+
+// Returns 0 if out of memory. size_hint is the size of the whole document
+static int srt_arena_add(srt_arena_t* arena, const utf8_char_t* text, size_t size, double str_pts, double end_pts, size_t size_hint)
+{
+    srt_t *srt, *prev;
+    size_t cue_size = srt_arena_cue_size(size);
+
+    if (arena->used + cue_size > arena->aloc) {
+        size_t grow = arena->aloc ? 2 * arena->aloc : SRT_ARENA_MIN_SIZE + size_hint;
+        size_t aloc = arena->used + cue_size > grow ? arena->used + cue_size : grow;
+        uint8_t* block = (uint8_t*)realloc(arena->block, aloc);
+
+        if (!block) {
+            return 0;
+        }
+
+        arena->block = block;
+        arena->aloc = aloc;
+    }
+
+    srt = (srt_t*)(arena->block + arena->used);
+    srt->next = 0;
+    srt->timestamp = str_pts;
+    srt->duration = end_pts - str_pts;
+    srt->aloc = size;
+    memcpy(srt_data(srt), text, size);
+    srt_data(srt)[size] = '\0';
+
+    if (arena->used) {
+        prev = (srt_t*)(arena->block + arena->prev);
+
+        if (0 >= prev->duration) {
+            prev->duration = str_pts - prev->timestamp;
+        }
+    }
+
+    arena->prev = arena->used;
+    arena->used += cue_size;
+    return 1;
+}
+
+// The block may have moved while growing, so the cues are linked once it is done
+static srt_t* srt_arena_link(srt_arena_t* arena)
+{
+    srt_t* srt;
+    size_t offset, next_offset;
+
+    if (!arena->used) {
+        free(arena->block);
+        return 0;
+    }
+
+    for (offset = 0; offset < arena->used; offset = next_offset) {
+        srt = (srt_t*)(arena->block + offset);
+        next_offset = offset + srt_arena_cue_size(srt->aloc);
+        srt->arena = (srt_t*)arena->block;
+        srt->next = next_offset < arena->used ? (srt_t*)(arena->block + next_offset) : 0;
+    }
+
+    return (srt_t*)arena->block;
+}
+
 srt_t* srt_parse(const utf8_char_t* data, size_t size)
 {
-    srt_t *head = 0, *prev = 0;
+    int blank;
+    const utf8_char_t *end, *text, *next;
     double str_pts = 0, end_pts = 0;
-    size_t line_length = 0, trimmed_length = 0;
-    int hh1, hh2, mm1, mm2, ss1, ss2, ms1, ms2;
+    srt_arena_t arena = { 0 };
 
     if (!data || !size) {
         return 0;
     }
 
-    for (;;) {
-        line_length = 0;
+    // Stop at a null terminator, if there is one
+    end = memchr(data, '\0', size);
+    end = end ? end : data + size;
 
+    while (data < end) {
+        // Skip empty lines, the first line with anything on it is the cue number
         do {
-            data += line_length;
-            size -= line_length;
-            line_length = utf8_line_length(data);
-            trimmed_length = utf8_trimmed_length(data, line_length);
-            // Skip empty lines
-        } while (0 < line_length && 0 == trimmed_length);
-
-        // linelength cant be zero before EOF
-        if (0 == line_length) {
+            next = srt_next_line(data, end, &blank);
+            data = next;
+        } while (blank && data < end);
+
+        if (blank) {
             break;
         }
 
-        data += line_length;
-        size -= line_length;
+        // A timing line that does not parse keeps the previous cue's times
+        next = srt_next_line(data, end, &blank);
+        srt_parse_timing(data, next, 0, &str_pts, &end_pts);
+        data = next;
 
-        line_length = utf8_line_length(data);
-        // printf ("time (%d): '%.*s'\n", line_length, (int) line_length, data);
+        // Caption text runs up to the next empty line
+        for (text = data; data < end; data = next) {
+            next = srt_next_line(data, end, &blank);
 
-        {
-            if (8 == sscanf(data, "%d:%2d:%2d%*1[,.]%3d --> %d:%2d:%2d%*1[,.]%3d", &hh1, &mm1, &ss1, &ms1, &hh2, &mm2, &ss2, &ms2)) {
-                str_pts = SRTTIME2SECONDS(hh1, mm1, ss1, ms1);
-                end_pts = SRTTIME2SECONDS(hh2, mm2, ss2, ms2);
+            if (blank) {
+                break;
             }
+        }
 
-            data += line_length;
-            size -= line_length;
+        if (!srt_arena_add(&arena, text, data - text, str_pts, end_pts, size)) {
+            break;
         }
 
-        // Caption text starts here
-        const utf8_char_t* text = data;
-        size_t text_size = 0;
+        data = next; // the empty line, if any
+    }
 
-        line_length = 0;
+    return srt_arena_link(&arena);
+}
 
-        do {
-            text_size += line_length;
-            line_length = utf8_line_length(data);
-            trimmed_length = utf8_trimmed_length(data, line_length);
-            // printf ("cap (%d): '%.*s'\n", line_length, (int) trimmed_length, data);
-            data += line_length;
-            size -= line_length;
-        } while (trimmed_length);
+// True if the line holds "-->"
+static int vtt_is_timing(const utf8_char_t* data, const utf8_char_t* end)
+{
+    for (; 3 <= end - data && (data = (const utf8_char_t*)memchr(data, '-', end - data - 2)); ++data) {
+        if ('-' == data[1] && '>' == data[2]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+srt_t* vtt_parse(const utf8_char_t* data, size_t size)
+{
+    int blank;
+    const utf8_char_t *end, *text, *next, *timing;
+    double str_pts, end_pts;
+    srt_arena_t arena = { 0 };
+
+    if (!data || !size) {
+        return 0;
+    }
+
+    end = memchr(data, '\0', size);
+    end = end ? end : data + size;
+
+    // An optional byte order mark, then WEBVTT alone on its line or followed by a space or tab
+    if (3 <= end - data && 0 == memcmp(data, "\xEF\xBB\xBF", 3)) {
+        data += 3;
+    }
+
+    if (6 > end - data || 0 != memcmp(data, "WEBVTT", 6) || (6 < end - data && ' ' != data[6] && '\t' != data[6] && '\r' != data[6] && '\n' != data[6])) {
+        return 0;
+    }
 
-        // should we trim here?
-        srt_t* srt = srt_new(text, text_size, str_pts, prev, &head);
-        prev = srt;
-        srt->duration = end_pts - str_pts;
+    // The header, X-TIMESTAMP-MAP and the like, runs to the first empty line. vtt_write puts
+    // the first cue right after it, so it also ends at a timing line, as in the WebVTT parser
+    for (data = srt_next_line(data, end, &blank); data < end; data = next) {
+        next = srt_next_line(data, end, &blank);
+
+        if (blank || vtt_is_timing(data, next)) {
+            break;
+        }
+    }
+
+    while (data < end) {
+        next = srt_next_line(data, end, &blank);
+
+        if (blank) {
+            data = next;
+            continue;
+        }
+
+        // The timing line comes first, or second after a cue identifier
+        timing = data;
+
+        if (!vtt_is_timing(timing, next)) {
+            timing = next;
+            next = srt_next_line(timing, end, &blank);
+        }
+
+        if (!blank && vtt_is_timing(timing, next) && srt_parse_timing(timing, next, 1, &str_pts, &end_pts)) {
+            // Cue settings after the end time are ignored. The payload runs to the next empty line,
+            // or to a line that is the timing of the next cue
+            for (text = data = next; data < end; data = next) {
+                next = srt_next_line(data, end, &blank);
+
+                if (blank || vtt_is_timing(data, next)) {
+                    break;
+                }
+            }
+
+            if (!srt_arena_add(&arena, text, data - text, str_pts, end_pts, size)) {
+                break;
+            }
+
+            continue;
+        }
+
+        // NOTE, STYLE and REGION blocks, and cues without valid timing
+        for (; data < end; data = next) {
+            next = srt_next_line(data, end, &blank);
+
+            if (blank) {
+                break;
+            }
+        }
     }
 
-    return head;
+    return srt_arena_link(&arena);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// incremental parser, follows the same rules as srt_parse
+enum {
+    srt_parser_counter,
+    srt_parser_timing,
+    srt_parser_text,
+};
+
+void srt_parser_init(srt_parser_t* parser)
+{
+    memset(parser, 0, sizeof(srt_parser_t));
+    parser->state = srt_parser_counter;
+    parser->blank = 1;
+}
+
+static srt_t* srt_parser_emit(srt_parser_t* parser, srt_t* prev, srt_t** head)
+{
+    srt_t* srt = srt_new(&parser->data[0], parser->line, parser->str_pts, prev, head);
+    srt->duration = parser->end_pts - parser->str_pts;
+    parser->state = srt_parser_counter;
+    parser->line = parser->size = 0;
+    return srt;
+}
+
+// Called on the first byte of a line ending, which has already been added to data
+static srt_t* srt_parser_line(srt_parser_t* parser, srt_t* prev, srt_t** head)
+{
+    parser->keep_pair = 0;
+
+    switch (parser->state) {
+    case srt_parser_counter:
+        if (!parser->blank) {
+            parser->state = srt_parser_timing;
+        }
+
+        break;
+
+    case srt_parser_timing:
+        srt_parse_timing(&parser->data[parser->line], &parser->data[parser->size], 0, &parser->str_pts, &parser->end_pts);
+        parser->state = srt_parser_text;
+        break;
+
+    case srt_parser_text:
+        if (parser->blank) {
+            return srt_parser_emit(parser, prev, head);
+        }
+
+        // keep this line as part of the cue text
+        parser->line = parser->size;
+        parser->keep_pair = 1;
+        return prev;
+    }
+
+    parser->size = parser->line;
+    return prev;
+}
+
+srt_t* srt_parser_push(srt_parser_t* parser, const utf8_char_t* data, size_t size, srt_t* prev, srt_t** head)
+{
+    for (; 0 < size; ++data, --size) {
+        utf8_char_t c = data[0];
+
+        if (parser->pair) {
+            utf8_char_t pair = parser->pair;
+            parser->pair = 0;
+
+            if (pair == c) {
+                if (parser->keep_pair && parser->size < SRT_PARSER_MAX_CUE_SIZE) {
+                    parser->data[parser->size++] = c;
+                    parser->line = parser->size;
+                }
+
+                continue;
+            }
+        }
+
+        if (parser->size < SRT_PARSER_MAX_CUE_SIZE) {
+            parser->data[parser->size++] = c;
+        }
+
+        if ('\r' == c || '\n' == c) {
+            parser->pair = '\r' == c ? '\n' : '\r';
+            prev = srt_parser_line(parser, prev, head);
+            parser->blank = 1;
+        } else if (' ' < (uint8_t)c) {
+            parser->blank = 0;
+        }
+    }
+
+    return prev;
+}
+
+srt_t* srt_parser_flush(srt_parser_t* parser, srt_t* prev, srt_t** head)
+{
+    // a last line without a line ending
+    if (parser->line < parser->size) {
+        if (srt_parser_text == parser->state && !parser->blank) {
+            parser->line = parser->size;
+        } else if (srt_parser_timing == parser->state) {
+            srt_parse_timing(&parser->data[parser->line], &parser->data[parser->size], 0, &parser->str_pts, &parser->end_pts);
+            parser->state = srt_parser_text;
+        } else if (srt_parser_counter == parser->state && !parser->blank) {
+            parser->state = srt_parser_timing;
+        }
+    }
+
+    if (srt_parser_counter != parser->state) {
+        prev = srt_parser_emit(parser, prev, head);
+    }
+
+    srt_parser_init(parser);
+    return prev;
 }
 
 int srt_to_caption_frame(srt_t* srt, caption_frame_t* frame)
@@ -156,39 +531,460 @@ srt_t* srt_from_caption_frame(caption_frame_t* frame, srt_t* prev, srt_t** head)
     return srt;
 }
 
-static inline void _crack_time(double tt, int* hh, int* mm, int* ss, int* ms)
+////////////////////////////////////////////////////////////////////////////////
+// index
+void srt_index_init(srt_index_t* index)
+{
+    index->size = 0;
+    index->aloc = 0;
+    index->entry = 0;
+}
+
+void srt_index_free(srt_index_t* index)
+{
+    free(index->entry);
+    srt_index_init(index);
+}
+
+static int srt_index_reserve(srt_index_t* index, size_t size)
+{
+    if (size > index->aloc) {
+        size_t aloc = index->aloc ? 2 * index->aloc : 64;
+        aloc = aloc < size ? size : aloc;
+        srt_index_entry_t* entry = (srt_index_entry_t*)realloc(index->entry, aloc * sizeof(srt_index_entry_t));
+
+        if (!entry) {
+            return 0;
+        }
+
+        index->entry = entry;
+        index->aloc = aloc;
+    }
+
+    return 1;
+}
+
+static inline double srt_end(const srt_t* srt) { return srt->timestamp + srt->duration; }
+
+// recalculate end_max from entry i onward
+static void srt_index_update(srt_index_t* index, size_t i)
+{
+    double end_max = 0 < i ? index->entry[i - 1].end_max : -DBL_MAX;
+
+    for (; i < index->size; ++i) {
+        double end = srt_end(index->entry[i].srt);
+        end_max = end > end_max ? end : end_max;
+        index->entry[i].end_max = end_max;
+    }
+}
+
+// Cues that start together are ordered by where they are in memory, which is list order for srt_parse
+static int srt_index_compare(const void* a, const void* b)
+{
+    const srt_index_entry_t* x = (const srt_index_entry_t*)a;
+    const srt_index_entry_t* y = (const srt_index_entry_t*)b;
+
+    if (x->start != y->start) {
+        return x->start < y->start ? -1 : 1;
+    }
+
+    return x->srt == y->srt ? 0 : x->srt < y->srt ? -1 : 1;
+}
+
+// first entry that starts after timestamp
+static size_t srt_index_upper_bound(const srt_index_t* index, double timestamp)
+{
+    size_t lo = 0, hi = index->size;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->entry[mid].start <= timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// first entry that starts at or after timestamp
+static size_t srt_index_lower_bound(const srt_index_t* index, double timestamp)
+{
+    size_t lo = 0, hi = index->size;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->entry[mid].start < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// first entry where a cue that started so far is still showing after timestamp.
+// Nothing before it can overlap timestamp
+static size_t srt_index_first_active(const srt_index_t* index, double timestamp)
+{
+    size_t lo = 0, hi = index->size;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->entry[mid].end_max <= timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+int srt_index_build(srt_index_t* index, srt_t* head)
+{
+    int sorted = 1;
+    size_t first = index->size;
+    srt_t* srt;
+
+    for (srt = head; srt; srt = srt_next(srt)) {
+        if (!srt_index_reserve(index, index->size + 1)) {
+            return 0;
+        }
+
+        index->entry[index->size].start = srt->timestamp;
+        index->entry[index->size].srt = srt;
+        sorted = sorted && (0 == index->size || index->entry[index->size - 1].start <= srt->timestamp);
+        ++index->size;
+    }
+
+    if (!sorted) {
+        qsort(index->entry, index->size, sizeof(srt_index_entry_t), srt_index_compare);
+        first = 0;
+    }
+
+    srt_index_update(index, first);
+    return 1;
+}
+
+int srt_index_add(srt_index_t* index, srt_t* srt)
+{
+    size_t i;
+
+    if (!srt_index_reserve(index, index->size + 1)) {
+        return 0;
+    }
+
+    i = srt_index_upper_bound(index, srt->timestamp);
+    memmove(&index->entry[i + 1], &index->entry[i], (index->size - i) * sizeof(srt_index_entry_t));
+    index->entry[i].start = srt->timestamp;
+    index->entry[i].srt = srt;
+    ++index->size;
+    srt_index_update(index, i);
+    return 1;
+}
+
+srt_t* srt_index_at(const srt_index_t* index, double timestamp)
 {
-    (*ms) = (int)((int64_t)(tt * 1000) % 1000);
-    (*ss) = (int)((int64_t)(tt) % 60);
-    (*mm) = (int)((int64_t)(tt / (60)) % 60);
-    (*hh) = (int)((int64_t)(tt / (60 * 60)));
+    size_t i, first = srt_index_first_active(index, timestamp);
+
+    for (i = srt_index_upper_bound(index, timestamp); i > first; --i) {
+        if (srt_end(index->entry[i - 1].srt) > timestamp) {
+            return index->entry[i - 1].srt;
+        }
+    }
+
+    return 0;
+}
+
+srt_t* srt_index_next(const srt_index_t* index, double timestamp)
+{
+    size_t i = srt_index_lower_bound(index, timestamp);
+    return i < index->size ? index->entry[i].srt : 0;
+}
+
+size_t srt_index_query(const srt_index_t* index, double start, double end, srt_t** cues, size_t max)
+{
+    size_t i, count = 0, stop = srt_index_lower_bound(index, end);
+
+    for (i = srt_index_first_active(index, start); i < stop; ++i) {
+        if (srt_end(index->entry[i].srt) > start) {
+            if (count < max) {
+                cues[count] = index->entry[i].srt;
+            }
+
+            ++count;
+        }
+    }
+
+    return count;
 }
 
-static void _dump(srt_t* head, char type)
+////////////////////////////////////////////////////////////////////////////////
+// writers
+// Writes value with at least width digits, returns the number of bytes written
+static size_t srt_format_int(utf8_char_t* data, int64_t value, int width)
+{
+    utf8_char_t digits[20];
+    size_t i, size = 0;
+
+    do {
+        digits[size++] = (utf8_char_t)('0' + value % 10);
+        value /= 10;
+    } while (value && size < sizeof(digits));
+
+    for (; size < (size_t)width; ++size) {
+        digits[size] = '0';
+    }
+
+    for (i = 0; i < size; ++i) {
+        data[i] = digits[size - 1 - i];
+    }
+
+    return size;
+}
+
+// H:MM:SS,mmm, the hours have at least hour_width digits. Negative times are written as zero
+static size_t srt_format_time(utf8_char_t* data, double tt, int hour_width, utf8_char_t separator)
+{
+    int64_t ms = 0 < tt ? (int64_t)(tt * 1000) : 0;
+    int64_t ss = ms / 1000;
+    size_t size = srt_format_int(data, ss / 3600, hour_width);
+    data[size++] = ':';
+    size += srt_format_int(&data[size], (ss / 60) % 60, 2);
+    data[size++] = ':';
+    size += srt_format_int(&data[size], ss % 60, 2);
+    data[size++] = separator;
+    size += srt_format_int(&data[size], ms % 1000, 3);
+    return size;
+}
+
+// start --> end and a line ending, the start hour is padded to hour_width
+static size_t srt_format_timing(utf8_char_t* data, double start, double end, int hour_width, utf8_char_t separator)
+{
+    size_t size = srt_format_time(data, start, hour_width, separator);
+    memcpy(&data[size], " --> ", 5);
+    size += 5;
+    size += srt_format_time(&data[size], end, 2, separator);
+    data[size++] = '\r';
+    data[size++] = '\n';
+    return size;
+}
+
+static int _write(srt_t* head, utf8_writer_t* writer, char type)
 {
     int i;
     srt_t* srt;
+    utf8_char_t timing[128];
 
     if ('v' == type) {
-        printf("WEBVTT\r\n");
+        utf8_writer_write(writer, "WEBVTT\r\n", 8);
     }
 
     for (srt = head, i = 1; srt; srt = srt_next(srt), ++i) {
-        int hh1, hh2, mm1, mm2, ss1, ss2, ms1, ms2;
-        _crack_time(srt->timestamp, &hh1, &mm1, &ss1, &ms1);
-        _crack_time(srt->timestamp + srt->duration, &hh2, &mm2, &ss2, &ms2);
+        size_t size = 0;
 
         if ('s' == type) {
-            printf("%02d\r\n%d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\r\n%s\r\n\r\n", i,
-                hh1, mm1, ss1, ms1, hh2, mm2, ss2, ms2, srt_data(srt));
+            size += srt_format_int(&timing[size], i, 2);
+            timing[size++] = '\r';
+            timing[size++] = '\n';
+        }
+
+        size += srt_format_timing(&timing[size], srt->timestamp, srt->timestamp + srt->duration, 1, 's' == type ? ',' : '.');
+        utf8_writer_write(writer, &timing[0], size);
+        utf8_writer_puts(writer, srt_data(srt));
+        utf8_writer_write(writer, "\r\n\r\n", 4);
+    }
+
+    return utf8_writer_flush(writer);
+}
+
+int srt_write(srt_t* head, utf8_writer_t* writer) { return _write(head, writer, 's'); }
+int vtt_write(srt_t* head, utf8_writer_t* writer) { return _write(head, writer, 'v'); }
+
+void srt_dump(srt_t* head)
+{
+    utf8_writer_t writer;
+    utf8_writer_init_file(&writer, stdout);
+    srt_write(head, &writer);
+}
+
+void vtt_dump(srt_t* head)
+{
+    utf8_writer_t writer;
+    utf8_writer_init_file(&writer, stdout);
+    vtt_write(head, &writer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// segmenter
+void vtt_segmenter_init(vtt_segmenter_t* seg, double duration, int64_t mpegts, vtt_segment_callback_t callback, void* opaque)
+{
+    memset(seg, 0, sizeof(vtt_segmenter_t));
+    seg->duration = duration;
+    seg->mpegts = mpegts;
+    seg->callback = callback;
+    seg->opaque = opaque;
+}
+
+void vtt_segmenter_free(vtt_segmenter_t* seg)
+{
+    srt_free(seg->carry);
+    free(seg->data);
+    seg->carry = 0;
+    seg->data = 0;
+    seg->size = seg->aloc = 0;
+}
+
+static inline double vtt_segment_start(vtt_segmenter_t* seg, unsigned sequence) { return sequence * seg->duration; }
+
+static void vtt_segmenter_append(vtt_segmenter_t* seg, const utf8_char_t* data, size_t size)
+{
+    if (seg->aloc < seg->size + size) {
+        size_t aloc = seg->aloc ? seg->aloc : 4096;
+        utf8_char_t* next;
+
+        while (aloc < seg->size + size) {
+            aloc *= 2;
         }
 
-        else if ('v' == type) {
-            printf("%d:%02d:%02d.%03d --> %02d:%02d:%02d.%03d\r\n%s\r\n\r\n",
-                hh1, mm1, ss1, ms1, hh2, mm2, ss2, ms2, srt_data(srt));
+        if (!(next = realloc(seg->data, aloc))) {
+            seg->error = 1;
+            return;
         }
+
+        seg->data = next;
+        seg->aloc = aloc;
+    }
+
+    memcpy(&seg->data[seg->size], data, size);
+    seg->size += size;
+}
+
+static inline void vtt_segmenter_puts(vtt_segmenter_t* seg, const utf8_char_t* str) { vtt_segmenter_append(seg, str, strlen(str)); }
+
+static void vtt_segmenter_cue(vtt_segmenter_t* seg, srt_t* srt)
+{
+    utf8_char_t timing[128];
+    double start = srt->timestamp, end = srt->timestamp + srt->duration;
+
+    if (seg->split) {
+        double seg_start = vtt_segment_start(seg, seg->sequence);
+        double seg_end = vtt_segment_start(seg, seg->sequence + 1);
+        start = start < seg_start ? seg_start : start;
+        end = seg_end < end ? seg_end : end;
     }
+
+    vtt_segmenter_append(seg, timing, srt_format_timing(timing, start, end, 2, '.'));
+    vtt_segmenter_puts(seg, srt_data(srt));
+    vtt_segmenter_puts(seg, "\r\n\r\n");
 }
 
-void srt_dump(srt_t* head) { _dump(head, 's'); }
-void vtt_dump(srt_t* head) { _dump(head, 'v'); }
+// Header, then whatever is carried over from earlier segments
+static void vtt_segmenter_open(vtt_segmenter_t* seg)
+{
+    srt_t* srt;
+    utf8_char_t mpegts[20];
+
+    vtt_segmenter_puts(seg, "WEBVTT\r\nX-TIMESTAMP-MAP=MPEGTS:");
+    vtt_segmenter_append(seg, mpegts, srt_format_int(mpegts, seg->mpegts, 1));
+    vtt_segmenter_puts(seg, ",LOCAL:00:00:00.000\r\n\r\n");
+
+    for (srt = seg->carry; srt; srt = srt_next(srt)) {
+        vtt_segmenter_cue(seg, srt);
+    }
+}
+
+static int vtt_segmenter_close(vtt_segmenter_t* seg, double duration)
+{
+    srt_t **carry = &seg->carry, *srt;
+    double start = vtt_segment_start(seg, seg->sequence);
+
+    if (!seg->size) {
+        vtt_segmenter_open(seg);
+    }
+
+    if (!seg->error && !seg->callback(seg->opaque, seg->sequence, start, duration, seg->data, seg->size)) {
+        seg->error = 1;
+    }
+
+    seg->size = 0;
+    start = vtt_segment_start(seg, ++seg->sequence);
+
+    // Carried cues are in start order, but not end order
+    while ((srt = *carry)) {
+        if (srt->timestamp + srt->duration <= start) {
+            (*carry) = srt_free_head(srt);
+        } else {
+            carry = &srt->next;
+        }
+    }
+
+    return !seg->error;
+}
+
+int vtt_segmenter_push(vtt_segmenter_t* seg, srt_t* srt)
+{
+    double end = srt->timestamp + srt->duration;
+
+    while (!seg->error && vtt_segment_start(seg, seg->sequence + 1) <= srt->timestamp) {
+        vtt_segmenter_close(seg, seg->duration);
+    }
+
+    if (seg->error || end <= srt->timestamp) {
+        return !seg->error;
+    }
+
+    if (!seg->size) {
+        vtt_segmenter_open(seg);
+    }
+
+    vtt_segmenter_cue(seg, srt);
+    seg->end = seg->end < end ? end : seg->end;
+
+    if (vtt_segment_start(seg, seg->sequence + 1) < end) {
+        const utf8_char_t* data = srt_data(srt);
+        srt_t *copy = srt_new(data, strlen(data), srt->timestamp, 0, 0), **tail = &seg->carry;
+
+        if (!copy) {
+            seg->error = 1;
+            return 0;
+        }
+
+        copy->duration = srt->duration;
+
+        while (*tail) {
+            tail = &(*tail)->next;
+        }
+
+        (*tail) = copy;
+    }
+
+    return !seg->error;
+}
+
+int vtt_segmenter_finish(vtt_segmenter_t* seg, double end)
+{
+    double start;
+
+    if (0 >= end) {
+        end = seg->end;
+    }
+
+    while (!seg->error && vtt_segment_start(seg, seg->sequence + 1) < end) {
+        vtt_segmenter_close(seg, seg->duration);
+    }
+
+    start = vtt_segment_start(seg, seg->sequence);
+
+    if (!seg->error && (seg->size || start < end)) {
+        vtt_segmenter_close(seg, start < end ? end - start : 0);
+    }
+
+    return !seg->error;
+}
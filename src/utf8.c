@@ -27,6 +27,71 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#include <emmintrin.h>
+#define UTF8_ASCII_SSE2
+#endif
+////////////////////////////////////////////////////////////////////////////////
+// ASCII fast paths. Caption text is almost all ASCII, so the helpers below skip runs of it
+// here and only decode multibyte characters one at a time.
+// Length of the run of non null ASCII bytes at the start of data, reading at most size bytes
+static size_t utf8_ascii_length(const utf8_char_t* data, size_t size)
+{
+    size_t i = 0;
+
+#ifdef UTF8_ASCII_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+
+        // top bit set for bytes above 0x7F, and for nulls once compared
+        if (_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero)))) {
+            break; // the scalar loop finds where the run ends
+        }
+    }
+#endif
+
+    for (; i < size && 0 < (int8_t)data[i]; ++i) {
+    }
+
+    return i;
+}
+
+// Length of data once trailing bytes at or below ' ' are removed
+static size_t utf8_ascii_trim(const utf8_char_t* data, size_t size)
+{
+#ifdef UTF8_ASCII_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+
+    while (16 <= size) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&data[size - 16]);
+
+        // unsigned v <= ' ' where min(v, ' ') == v
+        if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, space), v))) {
+            break;
+        }
+
+        size -= 16;
+    }
+#endif
+
+    for (; 0 < size && ' ' >= (uint8_t)data[size - 1]; --size) {
+    }
+
+    return size;
+}
+////////////////////////////////////////////////////////////////////////////////
+
 const utf8_char_t* utf8_char_next(const utf8_char_t* c)
 {
     const utf8_char_t* n = c + utf8_char_length(c);
@@ -79,19 +144,29 @@ int utf8_char_whitespace(const utf8_char_t* c)
 // size is number of charcter to count (0 to count until NULL term)
 size_t utf8_string_length(const utf8_char_t* data, utf8_size_t size)
 {
-    size_t char_length, byts = 0;
+    size_t char_length, ascii, byts = 0, bound = 0;
 
     if (0 == size) {
         size = utf8_char_count(data, 0);
     }
 
-    for (; 0 < size; --size) {
-        if (0 == (char_length = utf8_char_length(data))) {
+    while (0 < size) {
+        // Bytes are only read in bulk up to bound, which is before any null and no further than
+        // one byte per remaining character, so never past what the scalar loop would read
+        if (bound <= byts) {
+            bound = byts + strnlen(&data[byts], size);
+        }
+
+        ascii = utf8_ascii_length(&data[byts], bound - byts < size ? bound - byts : size);
+        byts += ascii;
+        size -= ascii;
+
+        if (0 == size || 0 == (char_length = utf8_char_length(&data[byts]))) {
             break;
         }
 
-        data += char_length;
         byts += char_length;
+        --size;
     }
 
     return byts;
@@ -121,7 +196,11 @@ utf8_size_t utf8_char_count(const char* data, size_t size)
     }
 
     for (i = 0; i < size; ++count, i += bytes) {
-        if (0 == (bytes = utf8_char_length(&data[i]))) {
+        bytes = utf8_ascii_length(&data[i], size - i);
+        count += bytes;
+        i += bytes;
+
+        if (i >= size || 0 == (bytes = utf8_char_length(&data[i]))) {
             break;
         }
     }
@@ -132,10 +211,7 @@ utf8_size_t utf8_char_count(const char* data, size_t size)
 // returnes the length of the line in bytes triming not printable charcters at the end
 size_t utf8_trimmed_length(const utf8_char_t* data, size_t size)
 {
-    for (; 0 < size && ' ' >= (uint8_t)data[size - 1]; --size) {
-    }
-
-    return size;
+    return utf8_ascii_trim(data, size);
 }
 
 // returns the length in bytes of the line including the new line charcter(s)
@@ -227,3 +303,163 @@ utf8_char_t* utf8_load_text_file(const char* path, size_t* size)
     data[*size] = 0;
     return data;
 }
+
+const utf8_char_t* utf8_map_text_file(const char* path, size_t* size)
+{
+    void* data = 0;
+    (*size) = 0;
+
+#ifdef _WIN32
+    LARGE_INTEGER file_size;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+    if (INVALID_HANDLE_VALUE == file) {
+        return 0;
+    }
+
+    if (!GetFileSizeEx(file, &file_size)) {
+        file_size.QuadPart = -1;
+    }
+
+    if (0 == file_size.QuadPart) {
+        data = (void*)"";
+    } else if (0 < file_size.QuadPart && (unsigned long long)file_size.QuadPart <= (size_t)-1) {
+        HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+
+        if (mapping) {
+            // the view keeps the mapping open
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+
+        (*size) = data ? (size_t)file_size.QuadPart : 0;
+    }
+
+    CloseHandle(file);
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (0 > fd) {
+        return 0;
+    }
+
+    if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode) || (unsigned long long)st.st_size > (size_t)-1) {
+        close(fd);
+        return 0;
+    }
+
+    if (0 == st.st_size) {
+        close(fd);
+        return "";
+    }
+
+    data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping holds its own reference
+
+    if (MAP_FAILED == data) {
+        return 0;
+    }
+
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL); // the parsers read front to back
+    (*size) = (size_t)st.st_size;
+#endif
+
+    return (const utf8_char_t*)data;
+}
+
+void utf8_unmap_text_file(const utf8_char_t* data, size_t size)
+{
+    // an empty file is not mapped
+    if (!data || !size) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+////////////////////////////////////////////////////////////////////////////////
+static size_t utf8_writer_file(void* opaque, const utf8_char_t* data, size_t size) { return fwrite(data, 1, size, (FILE*)opaque); }
+
+void utf8_writer_init_buffer(utf8_writer_t* writer, utf8_char_t* data, size_t size)
+{
+    writer->callback = 0;
+    writer->opaque = 0;
+    writer->data = size ? data : 0;
+    writer->size = size ? size - 1 : 0; // keep room for the null terminator
+    writer->used = 0;
+    writer->total = 0;
+    writer->error = (0 == size);
+
+    if (writer->data) {
+        writer->data[0] = '\0';
+    }
+}
+
+void utf8_writer_init_callback(utf8_writer_t* writer, utf8_writer_callback_t callback, void* opaque)
+{
+    writer->callback = callback;
+    writer->opaque = opaque;
+    writer->data = &writer->buffer[0];
+    writer->size = UTF8_WRITER_BUFFER_SIZE;
+    writer->used = 0;
+    writer->total = 0;
+    writer->error = 0;
+}
+
+void utf8_writer_init_file(utf8_writer_t* writer, FILE* file) { utf8_writer_init_callback(writer, utf8_writer_file, file); }
+
+int utf8_writer_flush(utf8_writer_t* writer)
+{
+    if (!writer->callback) {
+        return !writer->error;
+    }
+
+    if (writer->used && writer->used != writer->callback(writer->opaque, writer->data, writer->used)) {
+        writer->error = 1;
+    }
+
+    writer->used = 0;
+    return !writer->error;
+}
+
+static utf8_char_t* utf8_writer_reserve(utf8_writer_t* writer, size_t size)
+{
+    if (writer->used + size > writer->size && writer->callback) {
+        utf8_writer_flush(writer);
+    }
+
+    return writer->used + size <= writer->size ? &writer->data[writer->used] : 0;
+}
+
+void utf8_writer_write(utf8_writer_t* writer, const utf8_char_t* data, size_t size)
+{
+    utf8_char_t* dest = utf8_writer_reserve(writer, size);
+
+    if (dest) {
+        memcpy(dest, data, size);
+        writer->used += size;
+    } else if (writer->callback) {
+        // larger than the buffer, which utf8_writer_reserve has already flushed
+        if (size != writer->callback(writer->opaque, data, size)) {
+            writer->error = 1;
+        }
+    } else {
+        // copy what fits
+        if (writer->used < writer->size) {
+            memcpy(&writer->data[writer->used], data, writer->size - writer->used);
+            writer->used = writer->size;
+        }
+
+        writer->error = 1;
+    }
+
+    if (!writer->callback && writer->data) {
+        writer->data[writer->used] = '\0';
+    }
+
+    writer->total += size;
+}
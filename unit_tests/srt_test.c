@@ -0,0 +1,221 @@
+/**********************************************************************************************/
+/* The MIT License                                                                            */
+/*                                                                                            */
+/* Copyright 2016-2017 Twitch Interactive, Inc. or its affiliates. All Rights Reserved.       */
+/*                                                                                            */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy               */
+/* of this software and associated documentation files (the "Software"), to deal              */
+/* in the Software without restriction, including without limitation the rights               */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell                  */
+/* copies of the Software, and to permit persons to whom the Software is                      */
+/* furnished to do so, subject to the following conditions:                                   */
+/*                                                                                            */
+/* The above copyright notice and this permission notice shall be included in                 */
+/* all copies or substantial portions of the Software.                                        */
+/*                                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR                 */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,                   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE                */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER                     */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,              */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN                  */
+/* THE SOFTWARE.                                                                              */
+/**********************************************************************************************/
+#include "srt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+#define CHECK(COND)                                                      \
+    do {                                                                 \
+        if (!(COND)) {                                                   \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #COND); \
+            ++failures;                                                  \
+        }                                                                \
+    } while (0)
+
+static int same_time(double a, double b) { return -0.0005 < a - b && a - b < 0.0005; }
+
+static int same_cues(srt_t* a, srt_t* b)
+{
+    for (; a && b; a = srt_next(a), b = srt_next(b)) {
+        if (!same_time(a->timestamp, b->timestamp) || !same_time(a->duration, b->duration) || a->aloc != b->aloc || 0 != strcmp(srt_data(a), srt_data(b))) {
+            return 0;
+        }
+    }
+
+    return !a && !b;
+}
+
+static size_t count_cues(srt_t* srt)
+{
+    size_t count = 0;
+
+    for (; srt; srt = srt_next(srt)) {
+        ++count;
+    }
+
+    return count;
+}
+
+// Pushes data chunk bytes at a time, then flushes
+static srt_t* push_chunks(const utf8_char_t* data, size_t size, size_t chunk)
+{
+    srt_t *head = 0, *prev = 0;
+    srt_parser_t* parser = (srt_parser_t*)malloc(sizeof(srt_parser_t));
+    srt_parser_init(parser);
+
+    for (; chunk < size; data += chunk, size -= chunk) {
+        prev = srt_parser_push(parser, data, chunk, prev, &head);
+    }
+
+    prev = srt_parser_push(parser, data, size, prev, &head);
+    srt_parser_flush(parser, prev, &head);
+    free(parser);
+    return head;
+}
+
+// Mixed line endings, a multi line cue, a blank line run and a last cue with no line ending
+static const utf8_char_t srt_document[] = "1\r\n"
+                                          "00:00:01,000 --> 00:00:02,500\r\n"
+                                          "Hello\r\n"
+                                          "world\r\n"
+                                          "\r\n"
+                                          "\r\n"
+                                          "2\n"
+                                          "00:00:03,000 --> 00:00:04,000\n"
+                                          "Second\n"
+                                          "\n"
+                                          "3\r"
+                                          "01:00:05.250 --> 01:00:06,000\r"
+                                          "Last";
+
+static void test_srt_parse()
+{
+    srt_t* head = srt_parse(srt_document, sizeof(srt_document) - 1);
+    srt_t* srt = head;
+
+    CHECK(3 == count_cues(head));
+    CHECK(srt && same_time(1.0, srt->timestamp) && same_time(1.5, srt->duration) && 0 == strcmp("Hello\r\nworld\r\n", srt_data(srt)));
+    srt = srt ? srt_next(srt) : 0;
+    CHECK(srt && same_time(3.0, srt->timestamp) && same_time(1.0, srt->duration) && 0 == strcmp("Second\n", srt_data(srt)));
+    srt = srt ? srt_next(srt) : 0;
+    CHECK(srt && same_time(3605.25, srt->timestamp) && same_time(0.75, srt->duration) && 0 == strcmp("Last", srt_data(srt)));
+    srt_free(head);
+}
+
+// Every chunk size, so every line ending is split between calls somewhere
+static void test_srt_parser_chunks()
+{
+    size_t chunk, size = sizeof(srt_document) - 1;
+    srt_t* expect = srt_parse(srt_document, size);
+
+    for (chunk = 1; chunk <= size; ++chunk) {
+        srt_t* head = push_chunks(srt_document, size, chunk);
+        CHECK(same_cues(expect, head));
+        srt_free(head);
+    }
+
+    srt_free(expect);
+}
+
+// The LF of a CR LF pair arrives in the next call, and must not read as an empty line
+static void test_srt_parser_split_pair()
+{
+    srt_t *head = 0, *prev = 0;
+    srt_parser_t* parser = (srt_parser_t*)malloc(sizeof(srt_parser_t));
+    srt_parser_init(parser);
+
+    prev = srt_parser_push(parser, "1\r", 2, prev, &head);
+    prev = srt_parser_push(parser, "\n00:00:01,000 --> 00:00:02,000\r", 31, prev, &head);
+    prev = srt_parser_push(parser, "\nOne\r", 5, prev, &head);
+    prev = srt_parser_push(parser, "\nTwo\r", 5, prev, &head);
+    CHECK(!head);
+
+    prev = srt_parser_push(parser, "\n", 1, prev, &head);
+    CHECK(!head);
+
+    prev = srt_parser_push(parser, "\r", 1, prev, &head);
+    CHECK(head && head == prev && 0 == strcmp("One\r\nTwo\r\n", srt_data(head)));
+    CHECK(head && same_time(1.0, head->timestamp) && same_time(1.0, head->duration));
+
+    // the LF closing the empty line does not start anything
+    prev = srt_parser_push(parser, "\n", 1, prev, &head);
+    CHECK(prev == head);
+    CHECK(prev == srt_parser_flush(parser, prev, &head));
+    CHECK(1 == count_cues(head));
+    srt_free(head);
+    free(parser);
+}
+
+// Cue text past SRT_PARSER_MAX_CUE_SIZE is dropped, and the next cue is unaffected
+static void test_srt_parser_truncate()
+{
+    size_t size = 0, text_size = SRT_PARSER_MAX_CUE_SIZE + 1000;
+    utf8_char_t* data = (utf8_char_t*)malloc(text_size + 128);
+    srt_t *head, *srt;
+
+    size += sprintf(&data[size], "1\r\n00:00:01,000 --> 00:00:02,000\r\n");
+    memset(&data[size], 'x', text_size);
+    size += text_size;
+    size += sprintf(&data[size], "\r\n\r\n2\r\n00:00:10,000 --> 00:00:11,000\r\nNext\r\n\r\n");
+
+    head = push_chunks(data, size, 100);
+    CHECK(2 == count_cues(head));
+    srt = head;
+    CHECK(srt && SRT_PARSER_MAX_CUE_SIZE == srt->aloc && SRT_PARSER_MAX_CUE_SIZE == strspn(srt_data(srt), "x"));
+    srt = srt ? srt_next(srt) : 0;
+    CHECK(srt && same_time(10.0, srt->timestamp) && 0 == strcmp("Next\r\n", srt_data(srt)));
+    srt_free(head);
+    free(data);
+}
+
+static const utf8_char_t vtt_document[] = "WEBVTT - a title\r\n"
+                                          "X-TIMESTAMP-MAP=MPEGTS:900000,LOCAL:00:00:00.000\r\n"
+                                          "\r\n"
+                                          "NOTE this is\r\n"
+                                          "not a cue\r\n"
+                                          "\r\n"
+                                          "intro\r\n"
+                                          "00:01.000 --> 00:02.500 align:start line:0\r\n"
+                                          "Hourless\r\n"
+                                          "\r\n"
+                                          "00:00:03.000 --> 00:00:04.000\r\n"
+                                          "No identifier\r\n"
+                                          "00:00:05.000 --> 00:00:06.000\r\n"
+                                          "Right after\r\n";
+
+static void test_vtt_parse()
+{
+    srt_t* head = vtt_parse(vtt_document, sizeof(vtt_document) - 1);
+    srt_t* srt = head;
+
+    CHECK(3 == count_cues(head));
+    CHECK(srt && same_time(1.0, srt->timestamp) && same_time(1.5, srt->duration) && 0 == strcmp("Hourless\r\n", srt_data(srt)));
+    srt = srt ? srt_next(srt) : 0;
+    // the payload ends at the timing line of the next cue, even without an empty line
+    CHECK(srt && same_time(3.0, srt->timestamp) && same_time(1.0, srt->duration) && 0 == strcmp("No identifier\r\n", srt_data(srt)));
+    srt = srt ? srt_next(srt) : 0;
+    CHECK(srt && same_time(5.0, srt->timestamp) && same_time(1.0, srt->duration) && 0 == strcmp("Right after\r\n", srt_data(srt)));
+    srt_free(head);
+
+    CHECK(!vtt_parse("WEBVTTX\r\n\r\n00:01.000 --> 00:02.000\r\nNo\r\n", 40));
+    CHECK(!vtt_parse(srt_document, sizeof(srt_document) - 1));
+}
+
+int main(int argc, char** argv)
+{
+    test_srt_parse();
+    test_srt_parser_chunks();
+    test_srt_parser_split_pair();
+    test_srt_parser_truncate();
+    test_vtt_parse();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}